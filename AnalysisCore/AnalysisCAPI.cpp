@@ -0,0 +1,134 @@
+#include "AnalysisCAPI.h"
+#include <cmath>
+#include <memory>
+#include <string>
+#include <exception>
+#include "AnalysisTools.h"
+
+struct sp8_config {
+  std::unique_ptr<Analysis::JSONReader> pReader;
+  std::unique_ptr<Analysis::AnalysisTools> pTools;
+  std::unique_ptr<Analysis::Objects> pIons, pElectrons;
+  std::unique_ptr<Analysis::EventDataReader> pEventReader;
+  int maxNumOfIonHits, maxNumOfElecHits;
+};
+
+namespace {
+thread_local std::string lastError;
+
+sp8_config *createConfig(Analysis::JSONReader *pReader) {
+  std::unique_ptr<sp8_config> pConfig(new sp8_config);
+  pConfig->pReader.reset(pReader);
+  const Analysis::JSONReader &reader = *pReader;
+  pConfig->maxNumOfIonHits = reader.getIntAt("setup_input.max_number_of_ion_hits");
+  pConfig->maxNumOfElecHits = reader.getIntAt("setup_input.max_number_of_electron_hits");
+  pConfig->pTools.reset(new Analysis::AnalysisTools(Analysis::kUnit, reader));
+  pConfig->pIons.reset(new Analysis::Objects(Analysis::Objects::ions, pConfig->maxNumOfIonHits, reader, "ions."));
+  pConfig->pElectrons.reset(
+      new Analysis::Objects(Analysis::Objects::elecs, pConfig->maxNumOfElecHits, reader, "electrons."));
+  pConfig->pEventReader.reset(new Analysis::EventDataReader(pConfig->maxNumOfIonHits, pConfig->maxNumOfElecHits));
+  return pConfig.release();
+}
+}
+
+int sp8_api_version(void) { return SP8_API_VERSION; }
+
+sp8_config *sp8_config_open(const char *filename) {
+  try {
+    std::unique_ptr<Analysis::JSONReader> pReader(new Analysis::JSONReader());
+    pReader->appendDoc(Analysis::JSONReader::fromFile, filename);
+    const auto base = pReader->getOpt<const char *>("base_config_file");
+    if (base) { // relative to the working directory of sp8ana, without changing the one of the caller
+      std::string dir;
+      if (pReader->hasMember("working_directory")) {
+        dir = pReader->getStringAt("working_directory") + "/";
+      } else {
+        dir = filename;
+        const auto slash = dir.find_last_of("/\\");
+        dir = slash == std::string::npos ? "" : dir.substr(0, slash + 1);
+      }
+      const std::string path = *base;
+      pReader->appendDoc(Analysis::JSONReader::fromFile, path[0] == '/' ? path : dir + path);
+    }
+    return createConfig(pReader.release());
+  } catch (const std::exception &e) {
+    lastError = e.what();
+    return nullptr;
+  }
+}
+sp8_config *sp8_config_from_string(const char *json) {
+  try {
+    return createConfig(new Analysis::JSONReader(Analysis::JSONReader::fromStr, json));
+  } catch (const std::exception &e) {
+    lastError = e.what();
+    return nullptr;
+  }
+}
+void sp8_config_close(sp8_config *config) { delete config; }
+const char *sp8_last_error(void) { return lastError.c_str(); }
+int sp8_max_hits(const sp8_config *config, int objects) {
+  if (config == nullptr) return -1;
+  return objects == SP8_IONS ? config->maxNumOfIonHits : config->maxNumOfElecHits;
+}
+
+long sp8_calc_momenta(sp8_config *config, int objects, size_t numEvents,
+                      const double *x, const double *y, const double *t, const int32_t *flags,
+                      const int32_t *numHits,
+                      double *px, double *py, double *pz, double *energy, uint32_t *outFlags) {
+  typedef Analysis::EventDataReader R;
+  if (config == nullptr || x == nullptr || y == nullptr || t == nullptr || flags == nullptr) {
+    lastError = "the config and the inputs can not be NULL";
+    return -1;
+  }
+  if (objects != SP8_IONS && objects != SP8_ELECTRONS) {
+    lastError = "objects has to be SP8_IONS or SP8_ELECTRONS";
+    return -1;
+  }
+  const bool isIon = objects == SP8_IONS;
+  const int maxHits = isIon ? config->maxNumOfIonHits : config->maxNumOfElecHits;
+  const R::TreeName nameNum = isIon ? R::IonNum : R::ElecNum;
+  const R::TreeName nameX = isIon ? R::IonX : R::ElecX;
+  const R::TreeName nameY = isIon ? R::IonY : R::ElecY;
+  const R::TreeName nameT = isIon ? R::IonT : R::ElecT;
+  const R::TreeName nameFlag = isIon ? R::IonFlag : R::ElecFlag;
+  Analysis::EventDataReader &reader = *config->pEventReader;
+  Analysis::Objects &objs = isIon ? *config->pIons : *config->pElectrons;
+  const Analysis::AnalysisTools &tools = *config->pTools;
+  const int numObjs = objs.getNumberOfRealOrDummyObjects();
+  try {
+    for (size_t i = 0; i < numEvents; i++) {
+      const size_t k = i * maxHits;
+      reader.setNumObjs(nameNum) = numHits == nullptr ? -1 : numHits[i];
+      for (int j = 0; j < maxHits; j++) {
+        reader.setEventDataAt(nameX, j) = x[k + j];
+        reader.setEventDataAt(nameY, j) = y[k + j];
+        reader.setEventDataAt(nameT, j) = t[k + j];
+        reader.setFlagDataAt(nameFlag, j) = flags[k + j];
+      }
+      objs.resetEventData();
+      tools.loadEventDataInputer(objs, reader);
+      tools.loadMomentumCalculator(objs);
+      for (int j = 0; j < maxHits; j++) {
+        if (j >= numObjs) { // not analyzed by the config
+          if (px) px[k + j] = NAN;
+          if (py) py[k + j] = NAN;
+          if (pz) pz[k + j] = NAN;
+          if (energy) energy[k + j] = NAN;
+          if (outFlags) outFlags[k + j] = 0;
+          continue;
+        }
+        const Analysis::Object &obj = objs.getRealOrDummyObject(j);
+        const bool isHaving = obj.isFlag(Analysis::ObjectFlag::HavingMomentumData);
+        if (px) px[k + j] = isHaving ? Analysis::kUnit.writeAuMomentum(obj.getMomentumX()) : NAN;
+        if (py) py[k + j] = isHaving ? Analysis::kUnit.writeAuMomentum(obj.getMomentumY()) : NAN;
+        if (pz) pz[k + j] = isHaving ? Analysis::kUnit.writeAuMomentum(obj.getMomentumZ()) : NAN;
+        if (energy) energy[k + j] = isHaving ? Analysis::kUnit.writeElectronVolt(obj.getEnergy()) : NAN;
+        if (outFlags) outFlags[k + j] = obj.getLegacyFlag();
+      }
+    }
+  } catch (const std::exception &e) {
+    lastError = e.what();
+    return -1;
+  }
+  return (long) numEvents;
+}
@@ -0,0 +1,53 @@
+#ifndef ANALYSIS_ANALYSISCAPI_H
+#define ANALYSIS_ANALYSISCAPI_H
+
+/*
+ * C API of the analysis kernels in libanacore_c, for tools in other languages. The hits are
+ * analyzed by the same AnalysisTools and Objects as sp8ana, whole arrays at once.
+ *
+ * The arrays have maxHits slots per event in the layout of the sorted trees, hit j of event i
+ * at [i * maxHits + j], where maxHits is setup_input.max_number_of_ion_hits or _electron_hits of
+ * the config. The input is in the units of the trees: x, y [mm], t [ns] and the resort flags.
+ * The output is px, py, pz [au], energy [eV], NaN without momentum, and the flag of each object
+ * in the decimal-digit encoding of ObjectFlag::getLegacyFlag.
+ *
+ * A handle keeps the objects of one event and is not allocated again by the calls; use one handle
+ * per thread.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SP8_API_VERSION 1
+
+enum sp8_objects { SP8_IONS = 0, SP8_ELECTRONS = 1 };
+
+typedef struct sp8_config sp8_config;
+
+int sp8_api_version(void);
+/* the analysis config as read by sp8ana, with its base_config_file, NULL on error */
+sp8_config *sp8_config_open(const char *filename);
+sp8_config *sp8_config_from_string(const char *json);
+void sp8_config_close(sp8_config *config);
+/* the message of the last error of this thread */
+const char *sp8_last_error(void);
+int sp8_max_hits(const sp8_config *config, int objects);
+
+/*
+ * numHits: the number of hits of each event, NULL=all slots are read like a tree without them.
+ * The outputs may be NULL. Returns the number of events or -1 on error.
+ */
+long sp8_calc_momenta(sp8_config *config, int objects, size_t numEvents,
+                      const double *x, const double *y, const double *t, const int32_t *flags,
+                      const int32_t *numHits,
+                      double *px, double *py, double *pz, double *energy, uint32_t *outFlags);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //ANALYSIS_ANALYSISCAPI_H
@@ -239,16 +239,16 @@ void Analysis::AnalysisTools::loadEventDataInputer(Analysis::Object &obj,
                                                    const int &iHit) const {
   if (obj.isFlag(ObjectFlag::IonObject))
     loadEventDataInputer(obj,
-                         kUnit.readMilliMeter(reader.getEventDataAt(EventDataReader::IonX, iHit)),
-                         kUnit.readMilliMeter(reader.getEventDataAt(EventDataReader::IonY, iHit)),
-                         kUnit.readNanoSec(reader.getEventDataAt(EventDataReader::IonT, iHit)),
-                         reader.getFlagDataAt(EventDataReader::IonFlag, iHit));
+                         kUnit.readMilliMeter(reader.getEventDataAt<EventDataReader::IonX>(iHit)),
+                         kUnit.readMilliMeter(reader.getEventDataAt<EventDataReader::IonY>(iHit)),
+                         kUnit.readNanoSec(reader.getEventDataAt<EventDataReader::IonT>(iHit)),
+                         reader.getFlagDataAt<EventDataReader::IonFlag>(iHit));
   else if (obj.isFlag(ObjectFlag::ElecObject))
     loadEventDataInputer(obj,
-                         kUnit.readMilliMeter(reader.getEventDataAt(EventDataReader::ElecX, iHit)),
-                         kUnit.readMilliMeter(reader.getEventDataAt(EventDataReader::ElecY, iHit)),
-                         kUnit.readNanoSec(reader.getEventDataAt(EventDataReader::ElecT, iHit)),
-                         reader.getFlagDataAt(EventDataReader::ElecFlag, iHit));
+                         kUnit.readMilliMeter(reader.getEventDataAt<EventDataReader::ElecX>(iHit)),
+                         kUnit.readMilliMeter(reader.getEventDataAt<EventDataReader::ElecY>(iHit)),
+                         kUnit.readNanoSec(reader.getEventDataAt<EventDataReader::ElecT>(iHit)),
+                         reader.getFlagDataAt<EventDataReader::ElecFlag>(iHit));
 }
 void Analysis::AnalysisTools::loadEventDataInputer(Analysis::Objects &objs,
                                                    const EventDataReader &reader) const {
@@ -2,6 +2,7 @@
 // Created by Daehyun You on 12/1/15.
 //
 
+#include <algorithm>
 #include "EventDataReader.h"
 
 Analysis::EventDataReader::~EventDataReader() {
@@ -10,48 +11,27 @@ Analysis::EventDataReader::EventDataReader(const int maxNumOfIons, const int max
     : maxIons(maxNumOfIons), maxElecs(maxNumOfElecs) {
   eventData.resize((unsigned long) (3*(maxNumOfIons+maxNumOfElecs)));
   flagData.resize((unsigned long) (maxNumOfIons+maxNumOfElecs));
-  reset();
-}
-int Analysis::EventDataReader::getAdressAt(const TreeName name, const int i) const {
-  int adress = 0;
-  if(isAnyFlagTree(name)) {
-    adress += i;
-    if (name==IonFlag) {
-      assert(0 <= i && i<maxIons);
-    } else if (name==ElecFlag) {
-      assert(0 <= i && i<maxElecs);
-      adress += maxIons;
-    } else {
-      assert(false);
-      return intDum;
-    }
-    return adress;
-  } else if(isAnyEventTree(name)) {
-    adress += 3*i;
-    if (isAnyTTree(name)) {
-      adress += 0;
-    } else if (isAnyXTree(name)) {
-      adress += 1;
-    } else if (isAnyYTree(name)) {
-      adress += 2;
+  for (int n = 0; n < numTreeNames; n++) {
+    const TreeName name = (TreeName) n;
+    if (isAnyEventTree(name)) {
+      adressOffset[n] = (isAnyElecTree(name) ? 3*maxIons : 0) + getOffsetInHit(name);
+      adressStride[n] = 3;
+    } else if (isAnyFlagTree(name)) {
+      adressOffset[n] = isAnyElecTree(name) ? maxIons : 0;
+      adressStride[n] = 1;
     } else {
-      assert(false);
-      return intDum;
+      adressOffset[n] = intDum;
+      adressStride[n] = 0;
     }
-    if (isAnyIonTree(name)) {
-      assert(0 <= i && i<maxIons);
-    } else if (isAnyElecTree(name)) {
-      assert(0 <= i && i<maxElecs);
-      adress += 3*maxIons;
-    } else {
-      assert(false);
-      return intDum;
-    }
-    return adress;
-  } else {
-    assert(false);
-    return intDum;
   }
+  numIons = maxIons;
+  numElecs = maxElecs;
+  reset();
+}
+int Analysis::EventDataReader::getAdressAt(const TreeName name, const int i) const {
+  assert(isAnyEventTree(name) || isAnyFlagTree(name));
+  assert(0 <= i && i < (isAnyIonTree(name) ? maxIons : maxElecs));
+  return adressOffset[name] + adressStride[name]*i;
 }
 double Analysis::EventDataReader::getEventDataAt(const TreeName name, const int i) const {
   if (!isAnyEventTree(name)) assert(false);
@@ -72,10 +52,15 @@ int Analysis::EventDataReader::getFlagDataAt(const TreeName name, const int i) c
   else return flagData[getAdressAt(name, i)];
 }
 void Analysis::EventDataReader::reset() {
+  // only the hits of the last event can be filled
+  const int usedIons = std::max(0, std::min(getNumObjs(IonNum), maxIons));
+  const int usedElecs = std::max(0, std::min(getNumObjs(ElecNum), maxElecs));
+  std::fill(eventData.begin(), eventData.begin() + 3*usedIons, doubleDum);
+  std::fill(eventData.begin() + 3*maxIons, eventData.begin() + 3*(maxIons+usedElecs), doubleDum);
+  std::fill(flagData.begin(), flagData.begin() + usedIons, intDum);
+  std::fill(flagData.begin() + maxIons, flagData.begin() + maxIons + usedElecs, intDum);
   numIons = intDum;
   numElecs = intDum;
-  std::fill(eventData.begin(), eventData.end(), doubleDum);
-  std::fill(flagData.begin(), flagData.end(), intDum);
 }
 #define RETURN_VALNAME(NAME) case NAME: return #NAME ;
 #define RETURN_VALNAMEWITHNUM(NAME) case NAME: return std::string(#NAME)+ch;
@@ -125,51 +110,3 @@ bool Analysis::EventDataReader::returnDum(const Analysis::EventDataReader::TreeN
   if (isAnyIonTree(name)) return i >= getNumObjs(IonNum);
   else return i >= getNumObjs(ElecNum); // isAnyElecTree(name)
 }
-bool Analysis::EventDataReader::isAnyIonTree(const Analysis::EventDataReader::TreeName name) const {
-  for (TreeName n : {IonNum, IonT, IonX, IonY, IonFlag}) {
-    if (name==n) return true;
-  }
-  return false;
-}
-bool Analysis::EventDataReader::isAnyElecTree(const Analysis::EventDataReader::TreeName name) const {
-  for (TreeName n : {ElecNum, ElecT, ElecX, ElecY, ElecFlag}) {
-    if (name==n) return true;
-  }
-  return false;
-}
-bool Analysis::EventDataReader::isAnyNumTree(const Analysis::EventDataReader::TreeName name) const {
-  for (TreeName n : {IonNum, ElecNum}) {
-    if (name==n) return true;
-  }
-  return false;
-}
-bool Analysis::EventDataReader::isAnyEventTree(const Analysis::EventDataReader::TreeName name) const {
-  for (TreeName n : {IonT, IonX, IonY, ElecT, ElecX, ElecY}) {
-    if (name==n) return true;
-  }
-  return false;
-}
-bool Analysis::EventDataReader::isAnyFlagTree(const Analysis::EventDataReader::TreeName name) const {
-  for (TreeName n : {IonFlag, ElecFlag}) {
-    if (name==n) return true;
-  }
-  return false;
-}
-bool Analysis::EventDataReader::isAnyTTree(const Analysis::EventDataReader::TreeName name) const {
-  for (TreeName n : {IonT, ElecT}) {
-    if (name==n) return true;
-  }
-  return false;
-}
-bool Analysis::EventDataReader::isAnyXTree(const Analysis::EventDataReader::TreeName name) const {
-  for (TreeName n : {IonX, ElecX}) {
-    if (name==n) return true;
-  }
-  return false;
-}
-bool Analysis::EventDataReader::isAnyYTree(const Analysis::EventDataReader::TreeName name) const {
-  for (TreeName n : {IonY, ElecY}) {
-    if (name==n) return true;
-  }
-  return false;
-}
@@ -12,6 +12,13 @@
 
 namespace Analysis {
 class EventDataReader {
+ public:
+  enum TreeName{
+    IonNum, IonT, IonX, IonY, IonFlag,
+    ElecNum, ElecT, ElecX, ElecY, ElecFlag,
+    numTreeNames
+  };
+
  private:
   const int maxIons, maxElecs;
   const int intDum=-1;
@@ -19,16 +26,15 @@ class EventDataReader {
   int numIons, numElecs;
   std::vector<double> eventData;
   std::vector<int> flagData;
+  // adress of hit i of tree 'name' is adressOffset[name]+adressStride[name]*i
+  int adressOffset[numTreeNames];
+  int adressStride[numTreeNames];
  public:
   EventDataReader(const int maxNumOfIons, const int maxNumOfElecs);
   ~EventDataReader();
   void reset();
 
  public:
-  enum TreeName{
-    IonNum, IonT, IonX, IonY, IonFlag,
-    ElecNum, ElecT, ElecX, ElecY, ElecFlag
-  };
   double &setEventDataAt(const TreeName name, const int i);
   int &setFlagDataAt(const TreeName name, const int i);
   int &setNumObjs(const TreeName name);
@@ -37,18 +43,59 @@ class EventDataReader {
   int getNumObjs(const TreeName name) const;
   static std::string getTreeName(const TreeName name, const int i=-1);
 
+ public:
+  // same as above, but the layout of the tree is resolved at compile time
+  template<TreeName name> double getEventDataAt(const int i) const;
+  template<TreeName name> int getFlagDataAt(const int i) const;
+
  private:
   int getAdressAt(const TreeName name, const int i) const;
   bool returnDum(const TreeName name, const int i) const;
-  bool isAnyIonTree(const TreeName name) const;
-  bool isAnyElecTree(const TreeName name) const;
-  bool isAnyNumTree(const TreeName name) const;
-  bool isAnyEventTree(const TreeName name) const;
-  bool isAnyTTree(const TreeName name) const;
-  bool isAnyXTree(const TreeName name) const;
-  bool isAnyYTree(const TreeName name) const;
-  bool isAnyFlagTree(const TreeName name) const;
+  static constexpr bool isAnyIonTree(const TreeName name) {
+    return name == IonNum || name == IonT || name == IonX || name == IonY || name == IonFlag;
+  }
+  static constexpr bool isAnyElecTree(const TreeName name) {
+    return name == ElecNum || name == ElecT || name == ElecX || name == ElecY || name == ElecFlag;
+  }
+  static constexpr bool isAnyNumTree(const TreeName name) {
+    return name == IonNum || name == ElecNum;
+  }
+  static constexpr bool isAnyEventTree(const TreeName name) {
+    return isAnyTTree(name) || isAnyXTree(name) || isAnyYTree(name);
+  }
+  static constexpr bool isAnyTTree(const TreeName name) { return name == IonT || name == ElecT; }
+  static constexpr bool isAnyXTree(const TreeName name) { return name == IonX || name == ElecX; }
+  static constexpr bool isAnyYTree(const TreeName name) { return name == IonY || name == ElecY; }
+  static constexpr bool isAnyFlagTree(const TreeName name) { return name == IonFlag || name == ElecFlag; }
+  static constexpr int getOffsetInHit(const TreeName name) {
+    return isAnyTTree(name) ? 0 : (isAnyXTree(name) ? 1 : 2);
+  }
 };
 }
 
+template<Analysis::EventDataReader::TreeName name>
+double Analysis::EventDataReader::getEventDataAt(const int i) const {
+  static_assert(isAnyEventTree(name), "not an event tree");
+  assert(0 <= i);
+  if (isAnyIonTree(name)) {
+    if (i >= (numIons == intDum ? maxIons : numIons)) return doubleDum;
+    return eventData[3 * i + getOffsetInHit(name)];
+  } else {
+    if (i >= (numElecs == intDum ? maxElecs : numElecs)) return doubleDum;
+    return eventData[3 * (maxIons + i) + getOffsetInHit(name)];
+  }
+}
+template<Analysis::EventDataReader::TreeName name>
+int Analysis::EventDataReader::getFlagDataAt(const int i) const {
+  static_assert(isAnyFlagTree(name), "not a flag tree");
+  assert(0 <= i);
+  if (isAnyIonTree(name)) {
+    if (i >= (numIons == intDum ? maxIons : numIons)) return intDum;
+    return flagData[i];
+  } else {
+    if (i >= (numElecs == intDum ? maxElecs : numElecs)) return intDum;
+    return flagData[maxIons + i];
+  }
+}
+
 #endif //ANALYSIS_LMFREADER_H
@@ -7,29 +7,33 @@
 //#endif
 
 #include "LogWriter.h"
+#include <unistd.h>
 
-Analysis::LogWriter::LogWriter(const std::string prefix) : prefix(prefix) {
-  timeStamp = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-  std::tm *ptm = std::localtime(&timeStamp);
-  filename = prefix;
-  if(!(prefix == "")) { filename += "-"; }
-  filename += getTimeStamp();
-  logFile.open(filename + ".log", std::fstream::out);
-#ifndef __linux__
-  // todo: fix me 
-  logFile << "It is written at " << std::put_time(ptm,"%c") << std::endl;
-#endif 
-  logFile << std::endl;
-  return;
+static Analysis::LoggerConfig withLogFile(Analysis::LoggerConfig config, const std::string filename) {
+  if (config.filename.empty()) config.filename = filename + ".log";
+  return config;
+}
+const std::string Analysis::LogWriter::makeFilename(const std::string prefix, const std::time_t timeStamp) {
+  std::string str = prefix;
+  if(!(prefix == "")) { str += "-"; }
+  str += std::to_string(timeStamp);
+  return str;
+}
+Analysis::LogWriter::LogWriter(const std::string prefix, const LoggerConfig config)
+    : prefix(prefix),
+      timeStamp(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now())),
+      filename(makeFilename(prefix, timeStamp)),
+      pLogger(createLogger(filename, withLogFile(config, filename))),
+      logFile(pLogger) {
+  // the metadata of the run, the time is on every line
+  char host[256] = "";
+  gethostname(host, sizeof(host) - 1);
+  pLogger->info("run: {}, host: {}, pid: {}, time stamp: {}", filename, host, (int) getpid(), getTimeStamp());
 }
 Analysis::LogWriter::~LogWriter() {
-  std::time_t tt = std::chrono::system_clock::to_time_t (std::chrono::system_clock::now());
-  std::tm * ptm = std::localtime(&tt);
-#ifndef __linux__
-  // todo: fix me 
-  logFile << "It is closed at " << std::put_time(ptm,"%c") << std::endl;
-#endif 
-  logFile.close();
+  logFile.flush();
+  pLogger->info("run {} is closed", filename);
+  pLogger->flush();
 }
 const std::string Analysis::LogWriter::getTimeStamp() const {
   return std::to_string(timeStamp);
@@ -139,9 +143,12 @@ const std::string Analysis::LogWriter::getObjectName(int i) const {
     else { return str + "th Hit"; }
   }
 }
-std::fstream &Analysis::LogWriter::write() {
+std::ostream &Analysis::LogWriter::write() {
   return logFile;
 }
+spdlog::logger &Analysis::LogWriter::getLogger() {
+  return *pLogger;
+}
 const std::string Analysis::LogWriter::getFilename() const {
   return filename;
 }
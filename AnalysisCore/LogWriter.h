@@ -14,6 +14,7 @@
 #endif 
 #include <iomanip>
 #include "AnalysisTools.h"
+#include "../Core/Logger.h"
 
 namespace Analysis {
 class LogWriter {
@@ -21,11 +22,14 @@ class LogWriter {
   std::string prefix;
   std::time_t timeStamp;
   std::string filename;
-  std::fstream logFile;
+  std::shared_ptr<spdlog::logger> pLogger; // async, named after the run
+  LogStream logFile;
   const std::string getObjectName(int i) const;
+  static const std::string makeFilename(const std::string prefix, const std::time_t timeStamp);
 
  public:
-  LogWriter(const std::string prefix = "");
+  // the log file is filename.log unless the config has one
+  LogWriter(const std::string prefix = "", const LoggerConfig config = LoggerConfig());
   ~LogWriter();
   const std::string getPrefix() const;
   const std::string getTimeStamp() const;
@@ -34,7 +38,8 @@ class LogWriter {
                         const AnalysisTools &,
                         const Objects &ions,
                         const Objects &elecs);
-  std::fstream &write();
+  std::ostream &write();
+  spdlog::logger &getLogger();
 };
 }
 
@@ -7,57 +7,63 @@
 Analysis::ObjectFlag::ObjectFlag() : Flag() {
   return;
 }
+const unsigned int Analysis::ObjectFlag::getMasterRegion() const {
+  return (flag & maskForMasterRegion) >> shiftForMasterRegion;
+}
+void Analysis::ObjectFlag::setMasterRegion(const unsigned int f1) {
+  setBitField(shiftForMasterRegion, widthForMasterRegion, f1);
+}
 void Analysis::ObjectFlag::setWithinMasterRegion() {
-  if (get1stDigit() == initFlag) {
-    set1stDigit(flagFor1stDigit_withinMasterRegion);
+  if ((flag & maskForMasterRegion) == initFlag) {
+    setMasterRegion(flagForMasterRegion_within);
   }
 }
 void Analysis::ObjectFlag::setOutOfMasterRegion() {
-  const int n = get1stDigit();
-  if (n == initFlag || n == flagFor1stDigit_withinMasterRegion) {
-    set1stDigit(flagFor1stDigit_outOfMasterRegion);
+  const unsigned int n = getMasterRegion();
+  if (n == initFlag || n == flagForMasterRegion_within) {
+    setMasterRegion(flagForMasterRegion_outOf);
   }
 }
 void Analysis::ObjectFlag::setDead() {
-  const int n = get1stDigit();
+  const unsigned int n = getMasterRegion();
   if (n == initFlag
-      || n == flagFor1stDigit_withinMasterRegion
-      || n == flagFor1stDigit_outOfMasterRegion) {
-    set1stDigit(flagFor1stDigit_dead);
+      || n == flagForMasterRegion_within
+      || n == flagForMasterRegion_outOf) {
+    setMasterRegion(flagForMasterRegion_dead);
   }
 }
 const bool Analysis::ObjectFlag::isDead() const {
-	const auto f = get1stDigit();
-  return (f == initFlag) || (f == flagFor1stDigit_dead);
+  const unsigned int f = flag & maskForMasterRegion;
+  return (f == initFlag) || (f == (flagForMasterRegion_dead << shiftForMasterRegion));
 }
 const bool Analysis::ObjectFlag::isOutOfMasterRegion() const {
-  const int n = get1stDigit();
-  return n == flagFor1stDigit_outOfMasterRegion
-      || n == flagFor1stDigit_dead;
+  const unsigned int f = flag & maskForMasterRegion;
+  return f == (flagForMasterRegion_outOf << shiftForMasterRegion)
+      || f == (flagForMasterRegion_dead << shiftForMasterRegion);
 }
 const bool Analysis::ObjectFlag::isWithinMasterRegion() const {
-  return get1stDigit() == flagFor1stDigit_withinMasterRegion;
+  return (flag & maskForMasterRegion) == (flagForMasterRegion_within << shiftForMasterRegion);
 }
 void Analysis::ObjectFlag::setResortFlag(const int coboldFlag) {
-  setNthNumDigit(3, 2, convertCoboldFlag(coboldFlag));
+  setBitField(shiftForResort, widthForResort, convertCoboldFlag(coboldFlag));
 }
 const bool Analysis::ObjectFlag::isResortFlag(const int coboldFlag) const {
-  return getNthNumDigit(3, 2) == convertCoboldFlag(coboldFlag);
+  return (flag & maskForResort) == (convertCoboldFlag(coboldFlag) << shiftForResort);
 }
 const unsigned int Analysis::ObjectFlag::getResortFlag() const {
-  return convertToCoboldFlag(getNthNumDigit(3, 2));
+  return convertToCoboldFlag((flag & maskForResort) >> shiftForResort);
 }
 const unsigned int Analysis::ObjectFlag::convertCoboldFlag(const int coboldFlag) const {
   if(coboldFlag < (int) flagForResort_theRegion1) {
-    return flagFor3rd2Digit_lowerThanTheRegion;
+    return flagForStoredResort_lowerThanTheRegion;
   } else if(coboldFlag > (int) flagForResort_theRegion2) {
-    return flagFor3rd2Digit_upperThanTheRegion;
+    return flagForStoredResort_upperThanTheRegion;
   } else {
     return (coboldFlag - flagForResort_theRegion1 + 1);
   }
 }
 const unsigned int Analysis::ObjectFlag::convertToCoboldFlag(const unsigned int storedFlag) const {
-  if(!(storedFlag >= flagFor3rd2Digit_inTheRegion1 && storedFlag <= flagFor3rd2Digit_inTheRegion2)) {
+  if(!(storedFlag >= flagForStoredResort_inTheRegion1 && storedFlag <= flagForStoredResort_inTheRegion2)) {
     return flagForResort_outOfTheRegion;
   }
   return storedFlag + flagForResort_theRegion1 - 1;
@@ -73,34 +79,40 @@ const bool Analysis::ObjectFlag::isRisky() const {
 }
 Analysis::ObjectFlag::~ObjectFlag() {
 
+}
+const unsigned int Analysis::ObjectFlag::getData() const {
+  return (flag & maskForData) >> shiftForData;
+}
+void Analysis::ObjectFlag::setData(const unsigned int f1) {
+  setBitField(shiftForData, widthForData, f1);
 }
 void Analysis::ObjectFlag::setHavingNotProperData() {
-	const auto f0 = get2ndDigit();
-  if ((f0 == initFlag) || (f0 == flagFor2ndDigit_havingXYTData) || (f0 == flagFor2ndDigit_havingMomentumData)) {
-	  set2ndDigit(flagFor2ndDigit_havingNotProperData);
+  const unsigned int f0 = getData();
+  if ((f0 == initFlag) || (f0 == flagForData_havingXYTData) || (f0 == flagForData_havingMomentumData)) {
+    setData(flagForData_havingNotProperData);
   }
 }
 void Analysis::ObjectFlag::setHavingXYTData() {
-  if(get2ndDigit() == initFlag) {
-    set2ndDigit(flagFor2ndDigit_havingXYTData);
+  if ((flag & maskForData) == initFlag) {
+    setData(flagForData_havingXYTData);
   }
 }
 void Analysis::ObjectFlag::setHavingMomentumData() {
-  if(get2ndDigit() == flagFor2ndDigit_havingXYTData) {
-    set2ndDigit(flagFor2ndDigit_havingMomentumData);
+  if (getData() == flagForData_havingXYTData) {
+    setData(flagForData_havingMomentumData);
   }
 }
 const bool Analysis::ObjectFlag::isHavingNotProperData() const {
-	const auto f0 = get2ndDigit();
-	return (f0 == initFlag) || (f0 == flagFor2ndDigit_havingNotProperData);
+  const unsigned int f0 = flag & maskForData;
+  return (f0 == initFlag) || (f0 == (flagForData_havingNotProperData << shiftForData));
 }
 const bool Analysis::ObjectFlag::isHavingXYTData() const {
-  const unsigned int f0 = get2ndDigit();
-  return (f0 == flagFor2ndDigit_havingXYTData) || (f0 == flagFor2ndDigit_havingMomentumData);
+  const unsigned int f0 = flag & maskForData;
+  return (f0 == (flagForData_havingXYTData << shiftForData))
+      || (f0 == (flagForData_havingMomentumData << shiftForData));
 }
 const bool Analysis::ObjectFlag::isHavingMomentumData() const {
-  const unsigned int f0 = get2ndDigit();
-  return (f0 == flagFor2ndDigit_havingMomentumData);
+  return (flag & maskForData) == (flagForData_havingMomentumData << shiftForData);
 }
 #define ANALYSIS_OBJECTFLAG_CASESET(X) case X: set ## X(); break;
 void Analysis::ObjectFlag::setFlag(const FlagName flagName) {
@@ -166,35 +178,40 @@ const bool Analysis::ObjectFlag::isFlag(const FlagName flagName,
   return output;
 }
 void Analysis::ObjectFlag::setRealObject() {
-  if(getNthDigit(5) == initFlag)
-    setNthDigit(5, flagFor5thDigit_realObject);
+  if ((flag & maskForRealOrDummy) == initFlag)
+    setBitField(shiftForRealOrDummy, widthForRealOrDummy, flagForRealOrDummy_realObject);
 }
 void Analysis::ObjectFlag::setDummyObject() {
-  if(getNthDigit(5) == initFlag)
-    setNthDigit(5, flagFor5thDigit_dummyObject);
+  if ((flag & maskForRealOrDummy) == initFlag)
+    setBitField(shiftForRealOrDummy, widthForRealOrDummy, flagForRealOrDummy_dummyObject);
 }
 const bool Analysis::ObjectFlag::isRealObject() const {
-  return getNthDigit(5) == flagFor5thDigit_realObject;
+  return (flag & maskForRealOrDummy) == (flagForRealOrDummy_realObject << shiftForRealOrDummy);
 }
 const bool Analysis::ObjectFlag::isDummyObject() const {
-  return getNthDigit(5) == flagFor5thDigit_dummyObject;
+  return (flag & maskForRealOrDummy) == (flagForRealOrDummy_dummyObject << shiftForRealOrDummy);
 }
 void Analysis::ObjectFlag::setIonObject() {
-  if(getNthDigit(6) == initFlag)
-    setNthDigit(6, flagFor6thDigit_ionObject);
+  if ((flag & maskForIonOrElec) == initFlag)
+    setBitField(shiftForIonOrElec, widthForIonOrElec, flagForIonOrElec_ionObject);
 }
 void Analysis::ObjectFlag::setElecObject() {
-  if (getNthDigit(6)== initFlag)
-    setNthDigit(6, flagFor6thDigit_elecObject);
+  if ((flag & maskForIonOrElec) == initFlag)
+    setBitField(shiftForIonOrElec, widthForIonOrElec, flagForIonOrElec_elecObject);
 }
 const bool Analysis::ObjectFlag::isIonObject() const {
-  return getNthDigit(6) == flagFor6thDigit_ionObject;
+  return (flag & maskForIonOrElec) == (flagForIonOrElec_ionObject << shiftForIonOrElec);
 }
 const bool Analysis::ObjectFlag::isElecObject() const {
-  return getNthDigit(6) == flagFor6thDigit_elecObject;
+  return (flag & maskForIonOrElec) == (flagForIonOrElec_elecObject << shiftForIonOrElec);
 }
 void Analysis::ObjectFlag::resetFlag() {
-  setNthDigit(1, initFlag);
-  setNthDigit(2, initFlag);
-  setNthNumDigit(3, 2, initFlag);
+  flag &= ~(maskForMasterRegion | maskForData | maskForResort);
+}
+const unsigned int Analysis::ObjectFlag::getLegacyFlag() const {
+  return getMasterRegion()
+      + 10 * getData()
+      + 100 * ((flag & maskForResort) >> shiftForResort)
+      + 10000 * ((flag & maskForRealOrDummy) >> shiftForRealOrDummy)
+      + 100000 * ((flag & maskForIonOrElec) >> shiftForIonOrElec);
 }
@@ -38,10 +38,36 @@ class ObjectFlag: protected Flag {
   const bool isFlag(const FlagName flagName) const;
   const bool isFlag(const FlagName flagName, const int arg);
 
+ public:
+  // the decimal-digit encoding used by the older files:
+  // 1st digit: master region, 2nd: data, 3rd-4th: resort flag,
+  // 5th: real or dummy, 6th: ion or electron
+  const unsigned int getLegacyFlag() const;
+
+ private:
+  // bit layout of the flag
+  const unsigned int shiftForMasterRegion = 0;
+  const unsigned int widthForMasterRegion = 2;
+  const unsigned int shiftForData = 2;
+  const unsigned int widthForData = 2;
+  const unsigned int shiftForResort = 4;
+  const unsigned int widthForResort = 5;
+  const unsigned int shiftForRealOrDummy = 9;
+  const unsigned int widthForRealOrDummy = 2;
+  const unsigned int shiftForIonOrElec = 11;
+  const unsigned int widthForIonOrElec = 3;
+  const unsigned int maskForMasterRegion = 0x3u << shiftForMasterRegion;
+  const unsigned int maskForData = 0x3u << shiftForData;
+  const unsigned int maskForResort = 0x1fu << shiftForResort;
+  const unsigned int maskForRealOrDummy = 0x3u << shiftForRealOrDummy;
+  const unsigned int maskForIonOrElec = 0x7u << shiftForIonOrElec;
+
  private:
-  const unsigned int flagFor1stDigit_withinMasterRegion = 1;
-  const unsigned int flagFor1stDigit_outOfMasterRegion = 2;
-  const unsigned int flagFor1stDigit_dead = 3;
+  const unsigned int flagForMasterRegion_within = 1;
+  const unsigned int flagForMasterRegion_outOf = 2;
+  const unsigned int flagForMasterRegion_dead = 3;
+  const unsigned int getMasterRegion() const;
+  void setMasterRegion(const unsigned int f1);
   void setWithinMasterRegion();
   void setOutOfMasterRegion();
   void setDead();
@@ -50,9 +76,11 @@ class ObjectFlag: protected Flag {
   const bool isDead() const;
 
  private:
-  const unsigned int flagFor2ndDigit_havingNotProperData = 1;
-  const unsigned int flagFor2ndDigit_havingXYTData = 2;
-  const unsigned int flagFor2ndDigit_havingMomentumData = 3;
+  const unsigned int flagForData_havingNotProperData = 1;
+  const unsigned int flagForData_havingXYTData = 2;
+  const unsigned int flagForData_havingMomentumData = 3;
+  const unsigned int getData() const;
+  void setData(const unsigned int f1);
   void setHavingNotProperData();
   void setHavingXYTData();
   void setHavingMomentumData();
@@ -70,14 +98,14 @@ class ObjectFlag: protected Flag {
   const unsigned int flagForResort_secondMostReliableRegion2 = 14;
   const unsigned int flagForResort_riskyRegion1 = 15;
   const unsigned int flagForResort_riskyRegion2 = 20;
-  const unsigned int flagFor3rd2Digit_init = 0;
-  const unsigned int flagFor3rd2Digit_inTheRegion1 = 1;
-  const unsigned int flagFor3rd2Digit_inTheRegion2 =
+  const unsigned int flagForStoredResort_init = 0;
+  const unsigned int flagForStoredResort_inTheRegion1 = 1;
+  const unsigned int flagForStoredResort_inTheRegion2 =
       flagForResort_theRegion2 - flagForResort_theRegion1 + 1; // 21
   const unsigned int
-      flagFor3rd2Digit_lowerThanTheRegion = flagFor3rd2Digit_inTheRegion2 + 1;
+      flagForStoredResort_lowerThanTheRegion = flagForStoredResort_inTheRegion2 + 1;
   const unsigned int
-      flagFor3rd2Digit_upperThanTheRegion = flagFor3rd2Digit_inTheRegion2 + 2;
+      flagForStoredResort_upperThanTheRegion = flagForStoredResort_inTheRegion2 + 2;
   const unsigned int convertCoboldFlag(const int coboldFlag) const;
   const unsigned int convertToCoboldFlag(const unsigned int storedFlag) const;
   const unsigned int getResortFlag() const;
@@ -88,16 +116,16 @@ class ObjectFlag: protected Flag {
   const bool isRisky() const;
 
  private:
-  const unsigned int flagFor5thDigit_realObject = 1;
-  const unsigned int flagFor5thDigit_dummyObject = 2;
+  const unsigned int flagForRealOrDummy_realObject = 1;
+  const unsigned int flagForRealOrDummy_dummyObject = 2;
   void setRealObject();
   void setDummyObject();
   const bool isRealObject() const;
   const bool isDummyObject() const;
 
  private:
-  const unsigned int flagFor6thDigit_ionObject = 3;
-  const unsigned int flagFor6thDigit_elecObject = 4;
+  const unsigned int flagForIonOrElec_ionObject = 3;
+  const unsigned int flagForIonOrElec_elecObject = 4;
   void setIonObject();
   void setElecObject();
   const bool isIonObject() const;
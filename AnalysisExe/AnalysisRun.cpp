@@ -4,63 +4,84 @@
 
 #include "AnalysisRun.h"
 
-Analysis::AnalysisRun::AnalysisRun(const Analysis::JSONReader &configReader)
-    : Hist(false, numberOfHists) {
+Analysis::AnalysisRun::AnalysisRun(const Analysis::JSONReader &configReader, const bool isFused)
+    : Hist(false, numberOfHists),
+      timer({"GetEntry", "input", "momentum", "fillHists"}) {
 
   // Setup writer
   pLogWriter = new Analysis::LogWriter(
-      configReader.getStringAt("setup_output.filename_prefix"));
+      configReader.getStringAt("setup_output.filename_prefix"),
+      Analysis::readLoggerConfig(configReader, "setup_output.log", Analysis::LoggerConfig()));
 
-  // Setup input ROOT files
-  std::cout << "Setting up input root files... ";
-  pEventChain = new TChain(configReader.getStringAt("setup_input.tree_name").c_str());
-  pEventChain->Add(configReader.getStringAt("setup_input.filenames").c_str());
-  pLogWriter->write() << "Filenames: "
-                      << configReader.getStringAt("setup_input.filenames").c_str()
-                      << std::endl;
   maxNumOfIonHits = configReader.getIntAt("setup_input.max_number_of_ion_hits");
   maxNumOfElecHits = configReader.getIntAt("setup_input.max_number_of_electron_hits");
   pEventReader = new Analysis::EventDataReader(maxNumOfIonHits, maxNumOfElecHits);
-  if (configReader.getBoolAtIfItIs("setup_input.is_having_number_of_hits", false)) {
-    for (EventDataReader::TreeName name : {EventDataReader::IonNum,
-                                           EventDataReader::ElecNum}) {
-      pEventChain->SetBranchAddress(
-          EventDataReader::getTreeName(name).c_str(),
-          &(pEventReader->setNumObjs(name)));
+  isOwningEventReader = true;
+  pEventChain = nullptr;
+  pTools = nullptr;
+  pIons = nullptr;
+  pElectrons = nullptr;
+  try {
+    if (isFused) {
+      pLogWriter->write() << "Filenames: fused with sp8sort" << std::endl;
+    } else {
+      setupEventChain(configReader);
     }
+    setupTools(configReader);
+  } catch (...) { // not destructed, the analysis server goes on after a run which can not be set up
+    delete pElectrons;
+    delete pIons;
+    delete pTools;
+    delete pEventChain;
+    delete pEventReader;
+    delete pLogWriter;
+    throw;
   }
-  for (int i = 0; i < maxNumOfIonHits; i++) {
-    for (EventDataReader::TreeName name : {EventDataReader::IonX,
-                                           EventDataReader::IonY,
-                                           EventDataReader::IonT}) {
-      pEventChain->SetBranchAddress(
-          EventDataReader::getTreeName(name, i).c_str(),
-          &(pEventReader->setEventDataAt(name, i)));
-    }
-    {
-      EventDataReader::TreeName name = EventDataReader::IonFlag;
-      pEventChain->SetBranchAddress(
-          EventDataReader::getTreeName(name, i).c_str(),
-          &(pEventReader->setFlagDataAt(name, i)));
-    }
+  { // live snapshots for a viewer process
+    const auto pFile = configReader.getOpt<const char *>("setup_output.snapshot_file");
+    const auto pInterval = configReader.getOpt<double>("setup_output.snapshot_interval");
+    if (pFile) setSnapshot(*pFile, pInterval ? *pInterval : 2);
   }
-  for (int i = 0; i < maxNumOfElecHits; i++) {
-    for (EventDataReader::TreeName name : {EventDataReader::ElecX,
-                                           EventDataReader::ElecY,
-                                           EventDataReader::ElecT}) {
-      pEventChain->SetBranchAddress(
-          EventDataReader::getTreeName(name, i).c_str(),
-          &(pEventReader->setEventDataAt(name, i)));
-    }
-    {
-      EventDataReader::TreeName name = EventDataReader::ElecFlag;
-      pEventChain->SetBranchAddress(
-          EventDataReader::getTreeName(name, i).c_str(),
-          &(pEventReader->setFlagDataAt(name, i)));
-    }
+
+  // Initialization is done
+  timer.reset();
+  pLogWriter->write() << "Initialization is done." << std::endl;
+  pLogWriter->write() << std::endl;
+}
+
+Analysis::AnalysisRun::AnalysisRun(const Analysis::JSONReader &configReader,
+                                   Analysis::AnalysisRun &base,
+                                   const std::string name)
+    : Hist(false, numberOfHists),
+      timer({"GetEntry", "input", "momentum", "fillHists"}) {
+
+  // Setup writer, the files are named after the variant
+  const std::string prefix = configReader.getStringAt("setup_output.filename_prefix");
+  pLogWriter = new Analysis::LogWriter(
+      prefix.empty() ? name : prefix + "_" + name,
+      Analysis::readLoggerConfig(configReader, "setup_output.log", Analysis::LoggerConfig()));
+
+  // the event data is read by the base run
+  maxNumOfIonHits = base.maxNumOfIonHits;
+  maxNumOfElecHits = base.maxNumOfElecHits;
+  pEventReader = base.pEventReader;
+  isOwningEventReader = false;
+  pEventChain = nullptr;
+  pLogWriter->write() << "Filenames: variant " << name << " of " << base.pLogWriter->getFilename() << std::endl;
+  setupTools(configReader);
+  if (pIons->getNumberOfObjects() != base.pIons->getNumberOfObjects()
+      || pElectrons->getNumberOfObjects() != base.pElectrons->getNumberOfObjects()) {
+    throw std::invalid_argument("The variant " + name + " has to keep the number of hits of the base run!");
   }
-  std::cout << "ok" << std::endl;
+  base.variants.push_back(this);
 
+  // Initialization is done
+  timer.reset();
+  pLogWriter->write() << "Initialization is done." << std::endl;
+  pLogWriter->write() << std::endl;
+}
+
+void Analysis::AnalysisRun::setupTools(const Analysis::JSONReader &configReader) {
   // Make analysis tools, ions, and electrons
   pTools = new Analysis::AnalysisTools(kUnit, configReader);
   pIons = new Analysis::Objects(Objects::ions,
@@ -79,10 +100,6 @@ Analysis::AnalysisRun::AnalysisRun(const Analysis::JSONReader &configReader)
   openRootFile(rootFilename.c_str(), "NEW");
   createHists();
   std::cout << "ok" << std::endl;
-
-  // Initialization is done
-  pLogWriter->write() << "Initialization is done." << std::endl;
-  pLogWriter->write() << std::endl;
 }
 
 Analysis::AnalysisRun::~AnalysisRun() {
@@ -91,8 +108,13 @@ Analysis::AnalysisRun::~AnalysisRun() {
                       << std::endl;
 
   // flush ROOT file
+  publishSnapshot(true);
   flushRootFile();
 
+  // timing summary next to the root file
+  timer.report(pLogWriter->write(), true);
+  timer.writeJSON(pLogWriter->getFilename() + "_timing.json");
+
   // finalization is done
   if (pElectrons) {
     delete pElectrons;
@@ -106,7 +128,7 @@ Analysis::AnalysisRun::~AnalysisRun() {
     delete pTools;
     pTools = nullptr;
   }
-  if (pEventReader) {
+  if (pEventReader && isOwningEventReader) {
     delete pEventReader;
     pEventReader = nullptr;
   }
@@ -125,8 +147,19 @@ Analysis::AnalysisRun::~AnalysisRun() {
 
 void Analysis::AnalysisRun::processEvent(const long raw) {
   // Setup event chain
-  pEventChain->GetEntry(raw);
-
+  timer.mark();
+  const int bytes = pEventChain->GetEntry(raw);
+  timer.countEvent(bytes > 0 ? bytes : 0);
+  timer.lap(stageGetEntry);
+  analyzeEvent();
+}
+void Analysis::AnalysisRun::processEvent() {
+  // the event data is already in pEventReader
+  timer.mark();
+  timer.countEvent();
+  analyzeEvent();
+}
+void Analysis::AnalysisRun::analyzeEvent() {
   // Count event
   pTools->loadEventCounter();
 
@@ -137,20 +170,112 @@ void Analysis::AnalysisRun::processEvent(const long raw) {
   // input event data
   pTools->loadEventDataInputer(*pIons, *pEventReader);
   pTools->loadEventDataInputer(*pElectrons, *pEventReader);
+  timer.lap(stageInput);
 
-  // resort option
-  if (pIons->areAllFlag(ObjectFlag::MostOrSecondMostReliable)
-      && pElectrons->areAllFlag(ObjectFlag::MostOrSecondMostReliable)) {
-
+  // resort option, the resort flags do not depend on the parameters and the variants share the result
+  const bool isGated = pIons->areAllFlag(ObjectFlag::MostOrSecondMostReliable)
+      && pElectrons->areAllFlag(ObjectFlag::MostOrSecondMostReliable);
+  if (isGated) {
     pTools->loadMomentumCalculator(*pIons);
     pTools->loadMomentumCalculator(*pElectrons);
+    timer.lap(stageMomentum);
     fillHists();
+    timer.lap(stageFillHists);
   }
+  for (AnalysisRun *pVariant : variants) pVariant->analyzeGatedEvent(isGated);
+  publishSnapshot();
+  timer.report(std::cout);
+}
+void Analysis::AnalysisRun::analyzeGatedEvent(const bool isGated) {
+  // the event data is already in the reader of the base run
+  timer.mark();
+  timer.countEvent();
+  pTools->loadEventCounter();
+  if (!isGated) return;
+  pIons->resetEventData();
+  pElectrons->resetEventData();
+  pTools->loadEventDataInputer(*pIons, *pEventReader);
+  pTools->loadEventDataInputer(*pElectrons, *pEventReader);
+  timer.lap(stageInput);
+  pTools->loadMomentumCalculator(*pIons);
+  pTools->loadMomentumCalculator(*pElectrons);
+  timer.lap(stageMomentum);
+  fillHists();
+  timer.lap(stageFillHists);
 }
 
+void Analysis::AnalysisRun::setupEventChain(const Analysis::JSONReader &configReader) {
+  // Setup input ROOT files
+  std::cout << "Setting up input root files... ";
+  pEventChain = createEventChain(configReader, *pEventReader, maxNumOfIonHits, maxNumOfElecHits);
+  pLogWriter->write() << "Filenames: "
+                      << configReader.getStringAt("setup_input.filenames").c_str()
+                      << std::endl;
+  std::cout << "ok" << std::endl;
+}
+TChain *Analysis::AnalysisRun::createEventChain(const Analysis::JSONReader &configReader,
+                                                Analysis::EventDataReader &reader,
+                                                const int maxNumOfIonHits,
+                                                const int maxNumOfElecHits) {
+  auto pEventChain = new TChain(configReader.getStringAt("setup_input.tree_name").c_str());
+  pEventChain->Add(configReader.getStringAt("setup_input.filenames").c_str());
+  Analysis::EventDataReader *pEventReader = &reader;
+  if (configReader.getBoolAtIfItIs("setup_input.is_having_number_of_hits", false)) {
+    for (EventDataReader::TreeName name : {EventDataReader::IonNum,
+                                           EventDataReader::ElecNum}) {
+      pEventChain->SetBranchAddress(
+          EventDataReader::getTreeName(name).c_str(),
+          &(pEventReader->setNumObjs(name)));
+    }
+  }
+  for (int i = 0; i < maxNumOfIonHits; i++) {
+    for (EventDataReader::TreeName name : {EventDataReader::IonX,
+                                           EventDataReader::IonY,
+                                           EventDataReader::IonT}) {
+      pEventChain->SetBranchAddress(
+          EventDataReader::getTreeName(name, i).c_str(),
+          &(pEventReader->setEventDataAt(name, i)));
+    }
+    {
+      EventDataReader::TreeName name = EventDataReader::IonFlag;
+      pEventChain->SetBranchAddress(
+          EventDataReader::getTreeName(name, i).c_str(),
+          &(pEventReader->setFlagDataAt(name, i)));
+    }
+  }
+  for (int i = 0; i < maxNumOfElecHits; i++) {
+    for (EventDataReader::TreeName name : {EventDataReader::ElecX,
+                                           EventDataReader::ElecY,
+                                           EventDataReader::ElecT}) {
+      pEventChain->SetBranchAddress(
+          EventDataReader::getTreeName(name, i).c_str(),
+          &(pEventReader->setEventDataAt(name, i)));
+    }
+    {
+      EventDataReader::TreeName name = EventDataReader::ElecFlag;
+      pEventChain->SetBranchAddress(
+          EventDataReader::getTreeName(name, i).c_str(),
+          &(pEventReader->setFlagDataAt(name, i)));
+    }
+  }
+  return pEventChain;
+}
 const long Analysis::AnalysisRun::getEntries() const {
+  if (pEventChain == nullptr) return 0;
   return (long) pEventChain->GetEntries();
 }
+Analysis::EventDataReader &Analysis::AnalysisRun::getEventReader() {
+  return *pEventReader;
+}
+const int Analysis::AnalysisRun::getMaxNumOfIonHits() const {
+  return maxNumOfIonHits;
+}
+const int Analysis::AnalysisRun::getMaxNumOfElecHits() const {
+  return maxNumOfElecHits;
+}
+const std::string Analysis::AnalysisRun::getRootFilename() const {
+  return pLogWriter->getFilename() + ".root";
+}
 
 void Analysis::AnalysisRun::createHists() {
   // IonImage
@@ -14,6 +14,7 @@
 #include <unistd.h>
 #endif
 #include <string>
+#include <vector>
 #include <ctime>
 #include <TFile.h>
 #include <TChain.h>
@@ -23,6 +24,7 @@
 #include <RooDataProjBinding.h>
 #include "../Core/Hist.h"
 #include "../Core/Unit.h"
+#include "../Core/StageTimer.h"
 #include "../AnalysisCore/AnalysisTools.h"
 #include "../AnalysisCore/LogWriter.h"
 #include <numeric>
@@ -36,13 +38,31 @@ class AnalysisRun: Hist {
   Analysis::Objects *pIons;
   Analysis::Objects *pElectrons;
   Analysis::EventDataReader *pEventReader;
+  bool isOwningEventReader;
   Analysis::LogWriter *pLogWriter;
+  std::vector<AnalysisRun *> variants; // not owned
+  enum Stage { stageGetEntry, stageInput, stageMomentum, stageFillHists };
+  Analysis::StageTimer timer;
 
  public:
-  AnalysisRun(const Analysis::JSONReader &configReader);
+  // isFused=true: no input tree, the event data is set to getEventReader()
+  // by the caller (sp8sort) and processed by processEvent()
+  AnalysisRun(const Analysis::JSONReader &configReader, const bool isFused = false);
+  // a variant analyzes the events of the base run with another parameter set: the base run reads
+  // and flag-gates each event once, the variant has its own tools, objects, log and root file.
+  // The variants are deleted before the base run.
+  AnalysisRun(const Analysis::JSONReader &configReader, AnalysisRun &base, const std::string name);
   ~AnalysisRun();
   const long getEntries() const;
   void processEvent(const long raw);
+  void processEvent();
+  Analysis::EventDataReader &getEventReader();
+  const int getMaxNumOfIonHits() const;
+  const int getMaxNumOfElecHits() const;
+  const std::string getRootFilename() const;
+  // the chain of setup_input with its branches set to the reader
+  static TChain *createEventChain(const Analysis::JSONReader &configReader, Analysis::EventDataReader &reader,
+                                  const int maxNumOfIonHits, const int maxNumOfElecHits);
 
  private:
   enum HistList {
@@ -364,6 +384,10 @@ class AnalysisRun: Hist {
   };
   void createHists();
   void fillHists();
+  void setupEventChain(const Analysis::JSONReader &configReader);
+  void setupTools(const Analysis::JSONReader &configReader);
+  void analyzeEvent();
+  void analyzeGatedEvent(const bool isGated);
 };
 }
 
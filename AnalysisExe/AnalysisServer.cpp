@@ -0,0 +1,119 @@
+#include "AnalysisServer.h"
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include "AnalysisRun.h"
+
+Analysis::AnalysisServer::AnalysisServer(const Analysis::JSONReader &configReader,
+                                         std::shared_ptr<spdlog::logger> pLog)
+    : configReader(configReader), pLog(pLog),
+      maxNumOfIonHits(configReader.getIntAt("setup_input.max_number_of_ion_hits")),
+      maxNumOfElecHits(configReader.getIntAt("setup_input.max_number_of_electron_hits")),
+      cache(maxNumOfIonHits, maxNumOfElecHits), numRuns(0) {}
+
+long Analysis::AnalysisServer::loadEvents() {
+  // all the events are kept, a fragment may change the number of hits and so the gate
+  const auto pNumEvents = configReader.getOpt<int>("server.number_of_events");
+  const auto pStride = configReader.getOpt<int>("server.entry_stride");
+  pLog->info("Caching the events of {}...", configReader.getStringAt("setup_input.filenames"));
+  cache.load(configReader, pNumEvents ? *pNumEvents : 0, pStride ? *pStride : 1, false);
+  pLog->info("{} events are cached ({} MB).", cache.size(), cache.getBytes() / 1e6);
+  return cache.size();
+}
+
+bool Analysis::AnalysisServer::parseFragment(const std::string str, rapidjson::Document &fragment,
+                                             std::string &error) const {
+  std::string json = str;
+  if (json.empty()) {
+    json = "{}";
+  } else if (json[0] != '{') { // a file
+    std::ifstream file(str);
+    if (!file) {
+      error = "could not open " + str;
+      return false;
+    }
+    std::stringstream ss;
+    ss << file.rdbuf();
+    json = ss.str();
+  }
+  const unsigned flags =
+      rapidjson::kParseCommentsFlag + rapidjson::kParseTrailingCommasFlag + rapidjson::kParseNanAndInfFlag;
+  fragment.Parse<flags>(json.c_str());
+  if (fragment.HasParseError() || !fragment.IsObject()) {
+    error = "the fragment is not a JSON object";
+    return false;
+  }
+  return true;
+}
+
+void Analysis::AnalysisServer::runAnalysis(const rapidjson::Value &fragment, std::ostream &out) {
+  std::unique_ptr<JSONReader> pPatched(configReader.createPatched(fragment));
+  if (pPatched->getIntAt("setup_input.max_number_of_ion_hits") != maxNumOfIonHits
+      || pPatched->getIntAt("setup_input.max_number_of_electron_hits") != maxNumOfElecHits) {
+    out << "error: the numbers of hits of setup_input can not be changed" << std::endl;
+    return;
+  }
+
+  // the runs of the same second would share the file names
+  numRuns++;
+  const std::string prefix = pPatched->getStringAt("setup_output.filename_prefix");
+  const std::string name = (prefix.empty() ? "run" : prefix + "_run") + std::to_string(numRuns);
+  rapidjson::Document renaming;
+  renaming.SetObject();
+  {
+    auto &allocator = renaming.GetAllocator();
+    rapidjson::Value output(rapidjson::kObjectType);
+    output.AddMember("filename_prefix", rapidjson::Value(name.c_str(), allocator), allocator);
+    renaming.AddMember("setup_output", output, allocator);
+  }
+  std::unique_ptr<JSONReader> pReader(pPatched->createPatched(renaming));
+
+  const auto startTime = std::chrono::steady_clock::now();
+  std::string rootFilename;
+  {
+    AnalysisRun run(*pReader, true);
+    auto &reader = run.getEventReader();
+    for (long i = 0; i < cache.size(); i++) {
+      cache.get(i, reader);
+      run.processEvent();
+    }
+    rootFilename = run.getRootFilename();
+  } // the root file is written here
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  pLog->info("run {}: {} events in {} s, {}", numRuns, cache.size(), seconds, rootFilename);
+  out << "ok " << rootFilename << " " << cache.size() << " events " << seconds << " s" << std::endl;
+}
+
+void Analysis::AnalysisServer::serve(std::istream &in, std::ostream &out) {
+  out << "ok ready, " << cache.size() << " events" << std::endl;
+  std::string line;
+  while (std::getline(in, line)) {
+    const auto first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos) continue;
+    line = line.substr(first, line.find_last_not_of(" \t\r") - first + 1);
+    const auto space = line.find_first_of(" \t");
+    const std::string cmd = line.substr(0, space);
+    const std::string arg = space == std::string::npos ? "" : line.substr(line.find_first_not_of(" \t", space));
+    if (cmd == "quit" || cmd == "exit") {
+      out << "ok bye" << std::endl;
+      break;
+    } else if (cmd == "events") {
+      out << "ok " << cache.size() << " events " << cache.getBytes() / 1e6 << " MB" << std::endl;
+    } else if (cmd == "run") {
+      rapidjson::Document fragment;
+      std::string error;
+      if (!parseFragment(arg, fragment, error)) {
+        out << "error: " << error << std::endl;
+        continue;
+      }
+      try {
+        runAnalysis(fragment, out);
+      } catch (const std::exception &e) {
+        pLog->error("run {}: {}", numRuns, e.what());
+        out << "error: " << e.what() << std::endl;
+      }
+    } else {
+      out << "error: unknown command " << cmd << ", use run [FRAGMENT], events or quit" << std::endl;
+    }
+  }
+}
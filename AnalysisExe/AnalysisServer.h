@@ -0,0 +1,34 @@
+#ifndef ANALYSIS_ANALYSISSERVER_H
+#define ANALYSIS_ANALYSISSERVER_H
+
+#include <iostream>
+#include <string>
+#include <memory>
+#include "rapidjson/document.h"
+#include "../Core/JSONReader.h"
+#include "../Core/Logger.h"
+#include "EventCache.h"
+
+namespace Analysis {
+// Keeps the events of setup_input in memory and analyzes them again for each command, so a new cut
+// or histogram does not need to open the root files again. Commands, one per line:
+//   run [FRAGMENT]  FRAGMENT: a JSON object or a JSON file patching the config, a new root file is written
+//   events          the number of cached events
+//   quit
+// The replies start with "ok" or "error".
+class AnalysisServer {
+  const JSONReader &configReader;
+  std::shared_ptr<spdlog::logger> pLog;
+  const int maxNumOfIonHits, maxNumOfElecHits;
+  EventCache cache;
+  int numRuns;
+  bool parseFragment(const std::string str, rapidjson::Document &fragment, std::string &error) const;
+  void runAnalysis(const rapidjson::Value &fragment, std::ostream &out);
+ public:
+  AnalysisServer(const JSONReader &configReader, std::shared_ptr<spdlog::logger> pLog);
+  long loadEvents();
+  void serve(std::istream &in, std::ostream &out);
+};
+}
+
+#endif //ANALYSIS_ANALYSISSERVER_H
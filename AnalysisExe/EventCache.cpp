@@ -0,0 +1,78 @@
+#include "EventCache.h"
+#include <memory>
+#include "AnalysisRun.h"
+
+Analysis::EventCache::EventCache(const int maxNumOfIonHits, const int maxNumOfElecHits)
+    : maxNumOfIonHits(maxNumOfIonHits), maxNumOfElecHits(maxNumOfElecHits), numEvents(0) {}
+
+long Analysis::EventCache::load(const Analysis::JSONReader &configReader, const long maxNumOfEvents,
+                                const long entryStride, const bool isGated) {
+  EventDataReader reader(maxNumOfIonHits, maxNumOfElecHits);
+  std::unique_ptr<TChain> pChain(AnalysisRun::createEventChain(configReader, reader,
+                                                               maxNumOfIonHits, maxNumOfElecHits));
+  // the gate only needs the resort flags, the parameters of the config do not change it
+  AnalysisTools tools(kUnit, configReader);
+  Objects ions(Objects::ions, maxNumOfIonHits, configReader, "ions.");
+  Objects elecs(Objects::elecs, maxNumOfElecHits, configReader, "electrons.");
+  const long entries = (long) pChain->GetEntries();
+  const long stride = entryStride > 0 ? entryStride : 1;
+  const long n0 = numEvents;
+  for (long i = 0; i < entries; i += stride) {
+    if (maxNumOfEvents > 0 && numEvents - n0 >= maxNumOfEvents) break;
+    pChain->GetEntry(i);
+    if (isGated) {
+      ions.resetEventData();
+      elecs.resetEventData();
+      tools.loadEventDataInputer(ions, reader);
+      tools.loadEventDataInputer(elecs, reader);
+      if (!(ions.areAllFlag(ObjectFlag::MostOrSecondMostReliable)
+          && elecs.areAllFlag(ObjectFlag::MostOrSecondMostReliable))) {
+        continue;
+      }
+    }
+    push(reader);
+  }
+  return numEvents - n0;
+}
+void Analysis::EventCache::push(const Analysis::EventDataReader &reader) {
+  typedef EventDataReader R;
+  for (int j = 0; j < maxNumOfIonHits; j++) {
+    ionX.push_back(reader.getEventDataAt(R::IonX, j));
+    ionY.push_back(reader.getEventDataAt(R::IonY, j));
+    ionT.push_back(reader.getEventDataAt(R::IonT, j));
+    ionFlag.push_back(reader.getFlagDataAt(R::IonFlag, j));
+  }
+  for (int j = 0; j < maxNumOfElecHits; j++) {
+    elecX.push_back(reader.getEventDataAt(R::ElecX, j));
+    elecY.push_back(reader.getEventDataAt(R::ElecY, j));
+    elecT.push_back(reader.getEventDataAt(R::ElecT, j));
+    elecFlag.push_back(reader.getFlagDataAt(R::ElecFlag, j));
+  }
+  ionNum.push_back(reader.getNumObjs(R::IonNum));
+  elecNum.push_back(reader.getNumObjs(R::ElecNum));
+  numEvents++;
+}
+void Analysis::EventCache::get(const long i, Analysis::EventDataReader &reader) const {
+  typedef EventDataReader R;
+  reader.setNumObjs(R::IonNum) = ionNum[i];
+  reader.setNumObjs(R::ElecNum) = elecNum[i];
+  const long k = i * maxNumOfIonHits;
+  for (int j = 0; j < maxNumOfIonHits; j++) {
+    reader.setEventDataAt(R::IonX, j) = ionX[k + j];
+    reader.setEventDataAt(R::IonY, j) = ionY[k + j];
+    reader.setEventDataAt(R::IonT, j) = ionT[k + j];
+    reader.setFlagDataAt(R::IonFlag, j) = ionFlag[k + j];
+  }
+  const long l = i * maxNumOfElecHits;
+  for (int j = 0; j < maxNumOfElecHits; j++) {
+    reader.setEventDataAt(R::ElecX, j) = elecX[l + j];
+    reader.setEventDataAt(R::ElecY, j) = elecY[l + j];
+    reader.setEventDataAt(R::ElecT, j) = elecT[l + j];
+    reader.setFlagDataAt(R::ElecFlag, j) = elecFlag[l + j];
+  }
+}
+long Analysis::EventCache::size() const { return numEvents; }
+size_t Analysis::EventCache::getBytes() const {
+  const size_t numHits = (size_t) numEvents * (maxNumOfIonHits + maxNumOfElecHits);
+  return numHits * (3 * sizeof(double) + sizeof(int)) + 2 * (size_t) numEvents * sizeof(int);
+}
@@ -0,0 +1,29 @@
+#ifndef ANALYSIS_EVENTCACHE_H
+#define ANALYSIS_EVENTCACHE_H
+
+#include <vector>
+#include <cstddef>
+#include "../Core/JSONReader.h"
+#include "../AnalysisCore/EventDataReader.h"
+
+namespace Analysis {
+// Sorted events kept in memory, one column per branch of the hits, so the events are
+// analyzed again without reading the root files. Each event has maxNumOf*Hits slots.
+class EventCache {
+  const int maxNumOfIonHits, maxNumOfElecHits;
+  long numEvents;
+  std::vector<double> ionX, ionY, ionT, elecX, elecY, elecT;
+  std::vector<int> ionFlag, elecFlag, ionNum, elecNum;
+ public:
+  EventCache(const int maxNumOfIonHits, const int maxNumOfElecHits);
+  // reads every entryStride-th entry of setup_input up to maxNumOfEvents (0=all),
+  // isGated=true keeps only the events passing the resort flag gate of AnalysisRun
+  long load(const JSONReader &configReader, const long maxNumOfEvents, const long entryStride, const bool isGated);
+  void push(const EventDataReader &reader);
+  void get(const long i, EventDataReader &reader) const;
+  long size() const;
+  size_t getBytes() const;
+};
+}
+
+#endif //ANALYSIS_EVENTCACHE_H
@@ -4,9 +4,18 @@
 // #define ANALYSIS_DEBUG_BUILD
 
 #include <iostream>
+#include <memory>
+#include <streambuf>
+#include <cerrno>
+#include <cstdio>
 #include <thread>
+#include <vector>
 #include <stdlib.h>
+#include <unistd.h>
 #include "AnalysisRun.h"
+#include "ParameterOptimizer.h"
+#include "AnalysisServer.h"
+#include "../Core/Logger.h"
 
 void showProgressBar(const float prog = 0) {
   const int width = 50; // characters
@@ -25,6 +34,35 @@ void showProgressBar(const float prog = 0) {
   std::cout.flush();
 }
 
+// a buffered output stream on a file descriptor, the replies of the server
+class FdStreamBuf: public std::streambuf {
+  const int fd;
+  char buffer[4096];
+  bool flushBuffer() {
+    const char *p = pbase();
+    while (p < pptr()) {
+      const ssize_t n = write(fd, p, (size_t) (pptr() - p));
+      if (n < 0 && errno == EINTR) continue;
+      if (n < 0) return false;
+      p += n;
+    }
+    setp(buffer, buffer + sizeof(buffer));
+    return true;
+  }
+ protected:
+  int overflow(int c) override {
+    if (!flushBuffer()) return traits_type::eof();
+    if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+    return c;
+  }
+  int sync() override { return flushBuffer() ? 0 : -1; }
+ public:
+  explicit FdStreamBuf(const int fd) : fd(fd) { setp(buffer, buffer + sizeof(buffer)); }
+  ~FdStreamBuf() { sync(); }
+};
+
 enum StatusInfo {
   keepRunning,
   quitProgramSafely,
@@ -50,15 +88,35 @@ void inputManager(StatusInfo &info) {
 int main(int argc, char *argv[]) {
   // Inform status
   if (argc < 2) {
-    printf("syntax: AnalysisExe filename\n");
+    printf("syntax: AnalysisExe filename [optimize|serve]\n");
     printf("Please provide a filename.\n");
+    printf("        optimize: tune the parameters of the optimizer section on the cached events\n");
+    printf("        serve: keep the events in memory and analyze them for each run command from stdin\n");
     return 0;
   }
-  if (argc > 2) {
-    printf("syntax: AnalysisExe filename\n");
+  if (argc > 3) {
+    printf("syntax: AnalysisExe filename [optimize|serve]\n");
     printf("too many arguments\n");
     return 0;
   }
+  const bool isOptimizing = argc == 3 && std::string(argv[2]) == "optimize";
+  const bool isServing = argc == 3 && std::string(argv[2]) == "serve";
+  if (argc == 3 && !isOptimizing && !isServing) {
+    printf("Unknown command %s\n", argv[2]);
+    return 0;
+  }
+  // in the server mode stdout only carries the replies: the replies keep the real stdout and fd 1,
+  // which is written by std::cout, printf and ROOT, goes to stderr
+  std::unique_ptr<FdStreamBuf> pReplyBuf;
+  if (isServing) {
+    const int replyFd = dup(STDOUT_FILENO);
+    if (replyFd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+      printf("Could not separate the replies from the messages\n");
+      return 1;
+    }
+    pReplyBuf.reset(new FdStreamBuf(replyFd));
+  }
+  std::ostream replies(pReplyBuf ? pReplyBuf.get() : std::cout.rdbuf());
   std::cout << "arg 0: `" << argv[0] << "' is running now. " << std::endl;
   std::cout << "arg 1: `" << argv[1] << "' is going to be read for config file. " << std::endl;
   srand((unsigned int) time(nullptr));
@@ -86,31 +144,84 @@ int main(int argc, char *argv[]) {
     const auto base = pReader->getOpt<const char *>("base_config_file");
     if (base) pReader->appendDoc(Analysis::JSONReader::fromFile, *base);
   }
+  // messages of the program go to the console and the log file, the runs have their own logs
+  std::shared_ptr<spdlog::logger> pLog;
+  {
+    Analysis::LoggerConfig config;
+    config.isConsole = true;
+    config.isStderr = isServing;
+    pLog = Analysis::createLogger("sp8ana", Analysis::readLoggerConfig(*pReader, "log", config));
+    pLog->info("config: {}, pid: {}", argv[1], (int) getpid());
+  }
+
+  if (isOptimizing) { // no output file, the proposed parameters are written as a patch of this config
+    Analysis::ParameterOptimizer optimizer(*pReader, pLog);
+    optimizer.loadEvents();
+    const bool isDone = optimizer.optimize();
+    std::string filename = pReader->getStringAt("setup_output.filename_prefix") + "_optimized.json";
+    const auto pFilename = pReader->getOpt<const char *>("optimizer.output_file");
+    if (pFilename) filename = *pFilename;
+    if (isDone) {
+      if (optimizer.writeResult(filename)) pLog->info("The optimized parameters are written to {}", filename);
+      else pLog->error("Could not write {}", filename);
+    }
+    delete pReader;
+    pLog->info("The program is done.");
+    return isDone ? 0 : 1;
+  }
+
+  if (isServing) { // the commands are read from stdin until quit
+    Analysis::AnalysisServer server(*pReader, pLog);
+    server.loadEvents();
+    server.serve(std::cin, replies);
+    replies.flush();
+    delete pReader;
+    pLog->info("The program is done.");
+    return 0;
+  }
+
+  // parameter sets analyzed in the same pass over the events, patches of this config
+  std::vector<std::pair<std::string, std::unique_ptr<Analysis::JSONReader>>> variantReaders;
+  if (const auto pVariants = pReader->getOptValue("variants")) {
+    if (!pVariants->IsArray()) throw std::invalid_argument("variants has to be an array!");
+    for (const auto &patch : pVariants->GetArray()) {
+      if (!patch.IsObject() || !patch.HasMember("name") || !patch["name"].IsString()) {
+        throw std::invalid_argument("Each of variants needs a name!");
+      }
+      variantReaders.emplace_back(patch["name"].GetString(),
+                                  std::unique_ptr<Analysis::JSONReader>(pReader->createPatched(patch)));
+    }
+    pLog->info("number of variants: {}", variantReaders.size());
+  }
 
   // divid output files
   pRun = new Analysis::AnalysisRun(*pReader);
   const auto totalEntries = pRun->getEntries();
-  std::cout << "         total entries: " << totalEntries << std::endl;
+  pLog->info("total entries: {}", totalEntries);
   const auto limitEnt = pReader->getIntAt("setup_output.limitation_of_entries");
-  std::cout << " limitation of entries: " << limitEnt << std::endl;
+  pLog->info("limitation of entries: {}", limitEnt);
   const auto remainder = (int) (totalEntries % limitEnt);
   auto numFiles = (int) (totalEntries / limitEnt);
   if (remainder != 0) numFiles += 1;
   if (pReader->getBoolAt("setup_output.finish_after_filing_single_file")) numFiles = 1;
-  std::cout << "number of output files: " << numFiles << std::endl;
+  pLog->info("number of output files: {}", numFiles);
 
   // Make input thread
   std::cout << "make a thread to read keyboard hit... ";
   StatusInfo statusInfo = keepRunning;
   std::thread threadForInput(inputManager, std::ref(statusInfo));
   std::cout << "okay" << std::endl;
-  std::cout << "To quit this program safely, input 'quit'. " << std::endl;
+  pLog->info("To quit this program safely, input 'quit'.");
 
   // Run processes
   int currentPercentage = -1;
   for (int k = 0; k < numFiles; k++) {
     if (statusInfo == quitProgramSafely) break;
     if (k != 0) pRun = new Analysis::AnalysisRun(*pReader);
+    std::vector<Analysis::AnalysisRun *> variantRuns;
+    for (const auto &variant : variantReaders) {
+      variantRuns.push_back(new Analysis::AnalysisRun(*variant.second, *pRun, variant.first));
+    }
 
     for (int j = 0; j < limitEnt; j++) {
       const long i = k * ((long) limitEnt) + j;
@@ -122,6 +233,7 @@ int main(int argc, char *argv[]) {
       }
       pRun->processEvent(i);
     }
+    for (auto pVariantRun : variantRuns) delete pVariantRun;
     delete pRun;
     pRun = nullptr;
   }
@@ -129,10 +241,10 @@ int main(int argc, char *argv[]) {
   delete pReader;
 
   // Finish the program
-  std::cout << "closing the program... ";
+  pLog->info("closing the program...");
   statusInfo = done;
   threadForInput.detach();
   threadForInput.~thread();
-  std::cout << "okay" << std::endl;
+  pLog->info("The program is done.");
   return 0;
 }
@@ -0,0 +1,210 @@
+#include "ParameterOptimizer.h"
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <fstream>
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/stringbuffer.h"
+#include "AnalysisRun.h"
+
+Analysis::ParameterOptimizer::ParameterOptimizer(const Analysis::JSONReader &configReader,
+                                                 std::shared_ptr<spdlog::logger> pLog)
+    : configReader(configReader), pLog(pLog),
+      maxNumOfIonHits(configReader.getIntAt("setup_input.max_number_of_ion_hits")),
+      maxNumOfElecHits(configReader.getIntAt("setup_input.max_number_of_electron_hits")),
+      cache(maxNumOfIonHits, maxNumOfElecHits),
+      minAccepted(0), numEvaluations(0), initialRMS(NAN), finalRMS(NAN) {
+  const auto pNumEvents = configReader.getOpt<int>("optimizer.number_of_events");
+  const auto pStride = configReader.getOpt<int>("optimizer.entry_stride");
+  maxNumOfEvents = pNumEvents ? *pNumEvents : 100000;
+  entryStride = pStride && *pStride > 0 ? *pStride : 1;
+
+  for (const auto &parameter : configReader.getMap<double>("optimizer.parameters")) {
+    const auto pValue = configReader.getOpt<double>(parameter.first);
+    if (!pValue) throw std::invalid_argument("The parameter " + parameter.first + " is not in the config!");
+    if (!(parameter.second > 0)) throw std::invalid_argument("The step of " + parameter.first + " has to be positive!");
+    paths.push_back(parameter.first);
+    initialValues.push_back(*pValue);
+    initialSteps.push_back(parameter.second);
+  }
+  if (paths.empty()) throw std::invalid_argument("No parameter to optimize!");
+  values = initialValues;
+
+  const auto pTarget = configReader.getOpt<const char *>("optimizer.target");
+  const std::string targetName = pTarget ? *pTarget : "ions";
+  if (targetName == "ions") target = kIons;
+  else if (targetName == "electrons") target = kElectrons;
+  else if (targetName == "both") target = kBoth;
+  else throw std::invalid_argument("optimizer.target has to be ions, electrons or both!");
+
+  const auto pTolerance = configReader.getOpt<double>("optimizer.tolerance");
+  const auto pMaxEvaluations = configReader.getOpt<int>("optimizer.max_evaluations");
+  const auto pFraction = configReader.getOpt<double>("optimizer.min_accepted_fraction");
+  const auto pThreads = configReader.getOpt<int>("optimizer.threads");
+  tolerance = pTolerance ? *pTolerance : 0.01;
+  maxEvaluations = pMaxEvaluations ? *pMaxEvaluations : 500;
+  minAcceptedFraction = pFraction ? *pFraction : 0.5;
+  numThreads = pThreads && *pThreads > 0 ? *pThreads : (int) std::max(1u, std::thread::hardware_concurrency());
+}
+
+long Analysis::ParameterOptimizer::loadEvents() {
+  // the events are flag-gated once here, the resort flags do not depend on the parameters
+  pLog->info("Caching {} gated events from every {} entries...", maxNumOfEvents, entryStride);
+  cache.load(configReader, maxNumOfEvents, entryStride, true);
+  pLog->info("{} events are cached ({} MB).", cache.size(), cache.getBytes() / 1e6);
+  return cache.size();
+}
+
+rapidjson::Document Analysis::ParameterOptimizer::createPatch(const std::vector<double> &v) const {
+  rapidjson::Document patch;
+  patch.SetObject();
+  auto &allocator = patch.GetAllocator();
+  for (size_t k = 0; k < paths.size(); k++) {
+    // "ion_parameters.time_zero_of_TOF" -> {"ion_parameters": {"time_zero_of_TOF": v}}
+    rapidjson::Value *pV = &patch;
+    std::string path = paths[k];
+    while (true) {
+      const auto dot = path.find('.');
+      const std::string key = path.substr(0, dot);
+      if (!pV->HasMember(key.c_str())) {
+        rapidjson::Value name(key.c_str(), allocator), value;
+        if (dot == std::string::npos) value.SetDouble(v[k]);
+        else value.SetObject();
+        pV->AddMember(name, value, allocator);
+      }
+      pV = &(*pV)[key.c_str()];
+      if (dot == std::string::npos) break;
+      path = path.substr(dot + 1);
+    }
+  }
+  return patch;
+}
+
+double Analysis::ParameterOptimizer::evaluate(const std::vector<double> &v, long &numAccepted) const {
+  const rapidjson::Document patch = createPatch(v);
+  std::unique_ptr<JSONReader> pReader(configReader.createPatched(patch));
+  const AnalysisTools tools(kUnit, *pReader);
+
+  // the cached events are divided between the threads, each with its own objects
+  std::vector<std::unique_ptr<EventDataReader>> readers;
+  std::vector<std::unique_ptr<Objects>> ions, elecs;
+  for (int k = 0; k < numThreads; k++) {
+    readers.emplace_back(new EventDataReader(maxNumOfIonHits, maxNumOfElecHits));
+    ions.emplace_back(new Objects(Objects::ions, maxNumOfIonHits, *pReader, "ions."));
+    elecs.emplace_back(new Objects(Objects::elecs, maxNumOfElecHits, *pReader, "electrons."));
+  }
+  std::vector<double> sums(numThreads, 0);
+  std::vector<long> counts(numThreads, 0);
+  const auto run = [&](const int k) {
+    EventDataReader &reader = *readers[k];
+    Objects &iObjs = *ions[k];
+    Objects &eObjs = *elecs[k];
+    const long numEvents = cache.size();
+    const long n1 = numEvents * k / numThreads, n2 = numEvents * (k + 1) / numThreads;
+    for (long i = n1; i < n2; i++) {
+      cache.get(i, reader);
+      iObjs.resetEventData();
+      eObjs.resetEventData();
+      tools.loadEventDataInputer(iObjs, reader);
+      tools.loadEventDataInputer(eObjs, reader);
+      tools.loadMomentumCalculator(iObjs);
+      tools.loadMomentumCalculator(eObjs);
+      const bool isIon = target != kElectrons, isElec = target != kIons;
+      if (isIon && !iObjs.areAllFlag(ObjectFlag::HavingMomentumData)) continue;
+      if (isElec && !eObjs.areAllFlag(ObjectFlag::HavingMomentumData)) continue;
+      double px = 0, py = 0, pz = 0;
+      if (isIon) {
+        px += iObjs.getMomentumX();
+        py += iObjs.getMomentumY();
+        pz += iObjs.getMomentumZ();
+      }
+      if (isElec) {
+        px += eObjs.getMomentumX();
+        py += eObjs.getMomentumY();
+        pz += eObjs.getMomentumZ();
+      }
+      sums[k] += px * px + py * py + pz * pz;
+      counts[k]++;
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int k = 1; k < numThreads; k++) threads.emplace_back(run, k);
+  run(0);
+  for (auto &thread : threads) thread.join();
+
+  double sum = 0;
+  numAccepted = 0;
+  for (int k = 0; k < numThreads; k++) {
+    sum += sums[k];
+    numAccepted += counts[k];
+  }
+  if (numAccepted == 0 || numAccepted < minAccepted) return std::numeric_limits<double>::infinity();
+  return kUnit.writeAuMomentum(std::sqrt(sum / numAccepted));
+}
+
+bool Analysis::ParameterOptimizer::optimize() {
+  if (cache.size() == 0) {
+    pLog->error("No event is cached.");
+    return false;
+  }
+  // the trials may not win by losing the events out of the master regions
+  long numAccepted;
+  initialRMS = evaluate(initialValues, numAccepted);
+  numEvaluations = 1;
+  if (numAccepted == 0) {
+    pLog->error("No cached event has the momenta of the target with the initial parameters.");
+    return false;
+  }
+  minAccepted = (long) std::ceil(minAcceptedFraction * numAccepted);
+  pLog->info("initial RMS of the momentum sum: {} au from {} events", initialRMS, numAccepted);
+
+  // compass search: a step along one parameter is taken if it lowers the RMS,
+  // the steps are halved when none does
+  values = initialValues;
+  finalRMS = initialRMS;
+  std::vector<double> steps = initialSteps;
+  while (numEvaluations < maxEvaluations) {
+    bool isImproved = false;
+    for (size_t k = 0; k < paths.size() && !isImproved && numEvaluations < maxEvaluations; k++) {
+      for (const double sign : {1.0, -1.0}) {
+        std::vector<double> trial = values;
+        trial[k] += sign * steps[k];
+        const double rms = evaluate(trial, numAccepted);
+        numEvaluations++;
+        if (rms < finalRMS) {
+          values = trial;
+          finalRMS = rms;
+          isImproved = true;
+          pLog->debug("{} = {}: {} au from {} events", paths[k], values[k], rms, numAccepted);
+          break;
+        }
+      }
+    }
+    if (isImproved) continue;
+    bool isConverged = true;
+    for (size_t k = 0; k < paths.size(); k++) {
+      steps[k] /= 2;
+      isConverged = isConverged && steps[k] < tolerance * initialSteps[k];
+    }
+    if (isConverged) break;
+  }
+
+  pLog->info("final RMS of the momentum sum: {} au after {} evaluations", finalRMS, numEvaluations);
+  for (size_t k = 0; k < paths.size(); k++) {
+    pLog->info("    {}: {} -> {}", paths[k], initialValues[k], values[k]);
+  }
+  return true;
+}
+
+bool Analysis::ParameterOptimizer::writeResult(const std::string filename) const {
+  rapidjson::Document patch = createPatch(values);
+  patch.AddMember("name", "optimized", patch.GetAllocator());
+  rapidjson::StringBuffer buffer;
+  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+  patch.Accept(writer);
+  std::ofstream file(filename);
+  if (!file) return false;
+  file << "// initial RMS of the momentum sum: " << initialRMS << " au, final: " << finalRMS << " au" << std::endl;
+  file << buffer.GetString() << std::endl;
+  return (bool) file;
+}
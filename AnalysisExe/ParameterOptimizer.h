@@ -0,0 +1,48 @@
+#ifndef ANALYSIS_PARAMETEROPTIMIZER_H
+#define ANALYSIS_PARAMETEROPTIMIZER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include "rapidjson/document.h"
+#include "../Core/JSONReader.h"
+#include "../Core/Logger.h"
+#include "../AnalysisCore/AnalysisTools.h"
+#include "EventCache.h"
+
+namespace Analysis {
+// Tunes parameters of the analysis config, e.g. time_zero_of_TOF or x_zero_of_image, on a subsample
+// of the sorted events kept in memory. The tree is read once, then the momenta of the cached hits are
+// calculated again for each trial and a compass search minimizes the RMS of the momentum sum of the
+// target objects, which is 0 for a complete fragmentation channel.
+class ParameterOptimizer {
+ public:
+  enum Target { kIons, kElectrons, kBoth };
+
+ private:
+  const JSONReader &configReader;
+  std::shared_ptr<spdlog::logger> pLog;
+  int maxNumOfIonHits, maxNumOfElecHits;
+  long maxNumOfEvents, entryStride;
+  EventCache cache; // of the gated events
+  std::vector<std::string> paths; // dotted paths in the config
+  std::vector<double> initialValues, values, initialSteps;
+  Target target;
+  double tolerance, minAcceptedFraction;
+  int maxEvaluations, numThreads;
+  long minAccepted, numEvaluations;
+  double initialRMS, finalRMS;
+  rapidjson::Document createPatch(const std::vector<double> &v) const;
+  // [au], infinity if fewer than minAccepted events have the momenta of the target
+  double evaluate(const std::vector<double> &v, long &numAccepted) const;
+
+ public:
+  ParameterOptimizer(const JSONReader &configReader, std::shared_ptr<spdlog::logger> pLog);
+  long loadEvents(); // returns the number of cached events
+  bool optimize();
+  // a patch of the config with the optimized values, usable in "variants"
+  bool writeResult(const std::string filename) const;
+};
+}
+
+#endif //ANALYSIS_PARAMETEROPTIMIZER_H
@@ -0,0 +1,184 @@
+#include "LMFGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+
+Analysis::LMFGenerator::LMFGenerator(const Analysis::JSONReader &reader, const std::string prefix) {
+  numEvents = reader.get<int>(prefix + ".number_of_events");
+  if (numEvents < 1) throw std::invalid_argument("The number of events is invalid!");
+  const auto pSeed = reader.getOpt<int>(prefix + ".seed");
+  seed = pSeed ? (unsigned long long) *pSeed : 1;
+  multiplicity = reader.get<double>(prefix + ".multiplicity");
+  const auto pNoise = reader.getOpt<double>(prefix + ".noise");
+  noise = pNoise ? *pNoise : 0;
+  if (multiplicity < 0 || noise < 0) throw std::invalid_argument("The multiplicity or noise is invalid!");
+  const auto pTOF = reader.getOptArr<double>(prefix + ".tof");
+  if (pTOF && pTOF->size() == 2) {
+    tofFr = (*pTOF)[0];
+    tofTo = (*pTOF)[1];
+  } else {
+    tofFr = 1000;
+    tofTo = 5000;
+  }
+  if (tofTo < tofFr) throw std::invalid_argument("The TOF region is invalid!");
+  const auto pRate = reader.getOpt<double>(prefix + ".rate");
+  rate = pRate ? *pRate : 1e4;
+  if (rate <= 0) throw std::invalid_argument("The rate is invalid!");
+}
+bool Analysis::LMFGenerator::addDetector(const Analysis::JSONReader &reader, const std::string prefix) {
+  if (!reader.hasMember(prefix)) return false;
+  if (reader.get<int>(prefix + ".cmd") == -1) return false;
+  Detector det;
+  auto chMap = reader.getMap<int>(prefix + ".channel_map");
+  det.isHex = reader.getBoolAt(prefix + ".hexanode_used");
+  det.u1 = chMap["u1"] - 1;
+  det.u2 = chMap["u2"] - 1;
+  det.v1 = chMap["v1"] - 1;
+  det.v2 = chMap["v2"] - 1;
+  det.w1 = det.isHex ? chMap["w1"] - 1 : -1;
+  det.w2 = det.isHex ? chMap["w2"] - 1 : -1;
+  det.mcp = chMap["MCP"] - 1;
+  det.t0 = chMap["t0"] - 1;
+  auto factors = reader.getMap<double>(prefix + ".factors");
+  for (auto key: {"runtime_u", "runtime_v", "runtime_w"}) {
+    auto found = factors.find(key);
+    if (found == factors.end()) factors[key] = factors["runtime"];
+  }
+  det.runtimeU = factors["runtime_u"];
+  det.runtimeV = factors["runtime_v"];
+  det.runtimeW = factors["runtime_w"];
+  det.fu = 0.5 * factors["fu"];
+  det.fv = 0.5 * factors["fv"];
+  det.fw = 0.5 * factors["fw"];
+  det.radius = reader.getDoubleAt(prefix + ".MCP_radius");
+  det.anodeDeadtime = reader.getDoubleAt(prefix + ".anode_deadtime");
+  det.mcpDeadtime = reader.getDoubleAt(prefix + ".MCP_deadtime");
+  if (det.fu <= 0 || det.fv <= 0 || (det.isHex && det.fw <= 0))
+    throw std::invalid_argument("The scale factors of the detector are invalid!");
+  detectors.push_back(det);
+  return true;
+}
+void Analysis::LMFGenerator::setShifts(const Analysis::LMFWrapper &wrapper) {
+  shifts.clear();
+  for (size_t k = 0; k < wrapper.convChs.size(); ++k) shifts[wrapper.convChs[k]] = wrapper.convShifts[k];
+}
+double Analysis::LMFGenerator::uniform() {
+  return double(engine() >> 11) * (1.0 / 9007199254740992.0); // [0, 1) with 53 bits
+}
+int Analysis::LMFGenerator::poisson(const double mean) {
+  // Knuth's method, the means here are small
+  const double limit = std::exp(-mean);
+  int n = 0;
+  double p = uniform();
+  while (p > limit) {
+    ++n;
+    p *= uniform();
+  }
+  return n;
+}
+void Analysis::LMFGenerator::addHit(std::vector<double> *pHits, const int ch, const double t) const {
+  if (ch < 0 || ch >= NUM_CHANNELS) return;
+  // the conversion adds the shift back, so the sorter sees t
+  const auto found = shifts.find(ch);
+  pHits[ch].push_back(found == shifts.end() ? t : t - found->second);
+}
+bool Analysis::LMFGenerator::write(const std::string filename) {
+  if (detectors.empty()) {
+    std::cout << "No detector to generate." << std::endl;
+    return false;
+  }
+  engine.seed(seed);
+
+  int numChannels = 0;
+  for (const auto &det: detectors) {
+    for (const int ch: {det.u1, det.u2, det.v1, det.v2, det.w1, det.w2, det.mcp, det.t0}) {
+      numChannels = std::max(numChannels, ch + 1);
+    }
+  }
+  if (numChannels > NUM_CHANNELS) throw std::invalid_argument("The channel map is out of range!");
+
+  LMF_IO out(NUM_CHANNELS, NUM_IONS);
+  out.Starttime_output = time(nullptr);
+  out.prepare_Cobold2008b_TDC8HP_header_output();
+  // the header writer looks at the versions of an input file, there is none here
+  out.Cobold_Header_version = 2008;
+  out.CTime_version_output = 2005;
+  out.Stoptime_output = out.Starttime_output + time_t(numEvents / rate) + 1;
+  out.number_of_channels_output = numChannels;
+  out.max_number_of_hits_output = NUM_IONS;
+  out.Comment_output = "synthetic events of sp8bench";
+  if (!out.OpenOutputLMF(filename)) {
+    std::cout << "Could not open LMF file: " << filename << std::endl;
+    return false;
+  }
+
+  std::vector<double> hits[NUM_CHANNELS];
+  unsigned __int32 cnt[NUM_CHANNELS] = {0};
+  std::vector<__int32> tdc(NUM_CHANNELS * NUM_IONS, 0);
+  const double sqrt3 = std::sqrt(3.0);
+  for (long iEvent = 0; iEvent < numEvents; ++iEvent) {
+    for (auto &h: hits) h.clear();
+
+    for (const auto &det: detectors) {
+      // common start, t0 is the start signal of the TDC and may be shared by the detectors
+      if (det.t0 >= 0 && hits[det.t0].empty()) hits[det.t0].push_back(0);
+      const int n = poisson(multiplicity);
+      for (int i = 0; i < n; ++i) {
+        const double r = det.radius * std::sqrt(uniform());
+        const double phi = 2 * M_PI * uniform();
+        const double x = r * std::cos(phi), y = r * std::sin(phi);
+        const double mcp = tofFr + (tofTo - tofFr) * uniform();
+        // hexanode layers, see SortWrapper::getYRaw
+        const double u = x, v = (x - sqrt3 * y) / 2, w = (x + sqrt3 * y) / 2;
+        // the time sums are zero and the time differences are u/fu, v/fv, w/fw
+        addHit(hits, det.u1, mcp + 0.5 * u / det.fu);
+        addHit(hits, det.u2, mcp - 0.5 * u / det.fu);
+        addHit(hits, det.v1, mcp + 0.5 * v / det.fv);
+        addHit(hits, det.v2, mcp - 0.5 * v / det.fv);
+        if (det.isHex) {
+          addHit(hits, det.w1, mcp + 0.5 * w / det.fw);
+          addHit(hits, det.w2, mcp - 0.5 * w / det.fw);
+        }
+        addHit(hits, det.mcp, mcp);
+      }
+      const double runtime = std::max(det.runtimeU, std::max(det.runtimeV, det.runtimeW));
+      for (const int ch: {det.u1, det.u2, det.v1, det.v2, det.w1, det.w2, det.mcp}) {
+        if (ch < 0) continue;
+        const int m = poisson(noise);
+        for (int i = 0; i < m; ++i) addHit(hits, ch, tofFr + (tofTo - tofFr + runtime) * uniform());
+      }
+    }
+
+    // dead time and the TDC bins
+    for (int ch = 0; ch < numChannels; ++ch) {
+      auto &h = hits[ch];
+      std::sort(h.begin(), h.end());
+      double deadtime = 0;
+      for (const auto &det: detectors) {
+        if (ch == det.mcp) deadtime = det.mcpDeadtime;
+        else if (ch == det.u1 || ch == det.u2 || ch == det.v1 || ch == det.v2 || ch == det.w1 || ch == det.w2)
+          deadtime = det.anodeDeadtime;
+      }
+      unsigned __int32 k = 0;
+      double last = -1e300;
+      for (const double t: h) {
+        if (k >= NUM_IONS) break;
+        if (t - last < deadtime) continue;
+        tdc[ch * NUM_IONS + k] = (__int32) std::lround(t / TDCRes);
+        last = t;
+        ++k;
+      }
+      cnt[ch] = k;
+    }
+    out.WriteTDCData(double(iEvent) / rate, cnt, tdc.data());
+  }
+  out.CloseOutputLMF();
+  std::cout << "Generated " << numEvents << " events to " << filename << std::endl;
+  return true;
+}
+long Analysis::LMFGenerator::getNumEvents() const {
+  return numEvents;
+}
+int Analysis::LMFGenerator::getNumDetectors() const {
+  return (int) detectors.size();
+}
@@ -0,0 +1,53 @@
+#ifndef ANALYSIS_LMFGENERATOR_H
+#define ANALYSIS_LMFGENERATOR_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+#include "../SortExe/SortWrapper.h"
+#include "../Core/JSONReader.h"
+
+namespace Analysis {
+// Writes synthetic delay-line detector events to a TDC8HP LMF file.
+// The detectors are read from the sorter configs, so the sorters see a timesum
+// of zero and positions within the MCP radius after the conversion shifts.
+// The random numbers are drawn from mt19937_64 with own transforms,
+// so a seed gives the same file on every platform.
+class LMFGenerator {
+ public:
+  struct Detector {
+    int u1, u2, v1, v2, w1, w2, mcp, t0; // counting starts at 0, -1=not used
+    bool isHex;
+    double fu, fv, fw; // half of the config factors like sort_class
+    double runtimeU, runtimeV, runtimeW; // [ns]
+    double radius; // [mm]
+    double anodeDeadtime, mcpDeadtime; // [ns]
+  };
+
+ private:
+  std::vector<Detector> detectors;
+  std::map<int, double> shifts; // [ns] added by LMFWrapper::convertTDC
+  long numEvents;
+  unsigned long long seed;
+  double multiplicity; // mean number of particles per event and detector
+  double noise; // mean number of noise hits per event and channel
+  double tofFr, tofTo; // [ns]
+  double rate; // [Hz]
+  const double TDCRes = 0.025; // [ns]
+  std::mt19937_64 engine;
+  double uniform();
+  int poisson(const double mean);
+  void addHit(std::vector<double> *pHits, const int ch, const double t) const;
+
+ public:
+  LMFGenerator(const JSONReader &reader, const std::string prefix);
+  bool addDetector(const JSONReader &reader, const std::string prefix);
+  void setShifts(const LMFWrapper &wrapper);
+  bool write(const std::string filename);
+  long getNumEvents() const;
+  int getNumDetectors() const;
+};
+}
+
+#endif
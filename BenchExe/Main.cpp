@@ -0,0 +1,334 @@
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <unistd.h>
+#include "LMFGenerator.h"
+#include "../SortExe/SortWrapper.h"
+#include "../SortExe/SortRun.h"
+#include "../AnalysisExe/AnalysisRun.h"
+#include "../Core/StageTimer.h"
+
+typedef std::chrono::steady_clock Clock;
+
+struct BenchResult {
+  std::string name;
+  long ops;
+  double seconds;
+};
+
+double secondsSince(const Clock::time_point t) {
+  return std::chrono::duration<double>(Clock::now() - t).count();
+}
+
+void printResult(const BenchResult &r) {
+  std::cout << std::left << std::setw(24) << r.name << std::right
+            << std::setw(12) << r.ops << " ops "
+            << std::fixed << std::setprecision(1)
+            << std::setw(12) << (r.ops > 0 ? 1e9 * r.seconds / r.ops : 0) << " ns/op "
+            << std::setw(14) << (r.seconds > 0 ? r.ops / r.seconds : 0) << " ops/s" << std::endl;
+  std::cout.unsetf(std::ios_base::floatfield);
+}
+
+// the group-mode decoder of LMF_IO against its word-by-word reference on random TDC8HP words of
+// every class, random numbers of channels and hits, both resolutions and 8-bit wrapping rising offsets
+long checkTDC8HPDecoder(const long numGroups, const unsigned long long seed, long *pNumWords) {
+  std::mt19937_64 engine(seed);
+  std::vector<std::unique_ptr<LMF_IO>> lmfs;
+  for (const auto &dims: {std::make_pair(8, 1), std::make_pair(16, 4), std::make_pair(40, 10),
+                         std::make_pair(NUM_CHANNELS, NUM_IONS)}) {
+    lmfs.emplace_back(new LMF_IO(dims.first, dims.second));
+  }
+  const int offsets[] = {0, 8, 21, 64, 200, 250, -8};
+  std::vector<unsigned __int32> words;
+  long numMismatches = 0;
+  *pNumWords = 0;
+  for (long i = 0; i < numGroups; i++) {
+    LMF_IO &lmf = *lmfs[engine() % lmfs.size()];
+    lmf.TDC8HP.VHR_25ps = engine() % 2 == 0;
+    lmf.TDC8HP.channel_offset_for_rising_transitions = offsets[engine() % 7];
+    words.resize(engine() % 97);
+    for (auto &word: words) {
+      const unsigned __int32 low = (unsigned __int32) engine() & 0x00ffffff;
+      unsigned __int32 top;
+      switch (engine() % 10) {
+        case 0: top = 0x18 + engine() % 8; break; // level info
+        case 1: top = engine() % 0x10; break; // group
+        case 2: top = 0x10 + engine() % 0x30; break; // rollover and others
+        case 3: top = engine() % 0x100; break;
+        default: top = (engine() % 2 ? 0xC0 : 0x80) + engine() % 0x40; // rising or falling hit
+      }
+      word = top << 24 | low;
+    }
+    *pNumWords += (long) words.size();
+    if (!lmf.CompareTDC8HPGroupModeDecoders((__int32) words.size(), words.empty() ? nullptr : &words[0])) {
+      numMismatches++;
+    }
+  }
+  return numMismatches;
+}
+
+bool writeResults(const std::string filename, const long numEvents, const int numDetectors,
+                  const std::vector<BenchResult> &results, const std::string &stages) {
+  std::ofstream file(filename);
+  if (!file) return false;
+  file << std::setprecision(9);
+  file << "{\n";
+  file << "  \"events\": " << numEvents << ",\n";
+  file << "  \"detectors\": " << numDetectors << ",\n";
+  file << "  \"benchmarks\": [";
+  for (size_t i = 0; i < results.size(); i++) {
+    const auto &r = results[i];
+    file << (i == 0 ? "\n" : ",\n");
+    file << "    {\"name\": \"" << r.name << "\", "
+         << "\"ops\": " << r.ops << ", "
+         << "\"seconds\": " << r.seconds << ", "
+         << "\"ns_per_op\": " << (r.ops > 0 ? 1e9 * r.seconds / r.ops : 0) << ", "
+         << "\"ops_per_s\": " << (r.seconds > 0 ? r.ops / r.seconds : 0) << "}";
+  }
+  file << "\n  ],\n";
+  file << "  \"sort_stages\": " << stages;
+  file << "}\n";
+  return (bool) file;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    printf("syntax: sp8bench filename\n");
+    printf("        Synthetic events are written to the LMF file of the config,\n");
+    printf("        and the stages of sp8sort and sp8ana are timed on them.\n");
+    return 0;
+  }
+  std::cout << "The configure file which place at " << argv[1] << ", is going to be read. " << std::endl;
+
+  // Open the JSON reader
+  Analysis::JSONReader reader;
+  reader.appendDoc(Analysis::JSONReader::fromFile, argv[1]);
+  { // Change the working directory
+    std::string path;
+    if (reader.hasMember("working_directory")) {
+      path = reader.getStringAt("working_directory");
+    } else {
+      path = argv[1];
+      path = path.substr(0, path.find_last_of("/\\"));
+    }
+    std::cout << "changing path to `" << path << std::endl;
+    chdir(path.c_str());
+  }
+  { // read base config file
+    const auto base = reader.getOpt<const char *>("base_config_file");
+    if (base) reader.appendDoc(Analysis::JSONReader::fromFile, *base);
+  }
+  const auto maxElecHits = reader.get<int>("maxium_of_electron_hits");
+  const auto maxIonHits = reader.get<int>("maxium_of_ion_hits");
+  const auto pHistFills = reader.getOpt<int>("benchmark.hist_fills");
+  const long numHistFills = pHistFills ? *pHistFills : 1000000;
+  const auto pRepeats = reader.getOpt<int>("benchmark.momentum_repeats");
+  const int numMomentumRepeats = pRepeats ? std::max(*pRepeats, 1) : 10;
+  const auto pAnaConfig = reader.getOpt<const char *>("benchmark.analysis_config");
+  const auto pDecoderGroups = reader.getOpt<int>("benchmark.decoder_check_groups");
+  const long numDecoderGroups = pDecoderGroups ? *pDecoderGroups : 100000;
+  const auto pSeed = reader.getOpt<int>("generator.seed");
+  const auto pResultFile = reader.getOpt<const char *>("benchmark.result_file");
+  const std::string resultFilename = pResultFile ? *pResultFile : "BenchResult.json";
+
+  // Setup the sorters, the shifts of the conversion are known after init
+  Analysis::LMFWrapper aLMFWrapper;
+  if (!aLMFWrapper.readConfig(reader)) throw std::invalid_argument("The LMF file to generate is not set!");
+  Analysis::SortWrapper iSortWrapper(&aLMFWrapper), eSortWrapper(&aLMFWrapper);
+  {
+    const bool b1 = iSortWrapper.readConfig(reader, "ion_sorter");
+    const bool b2 = eSortWrapper.readConfig(reader, "electron_sorter");
+    if (!b1 || !b2) throw std::invalid_argument("Fail to read the config file!");
+    if (!iSortWrapper.readCalibTab() || !eSortWrapper.readCalibTab())
+      throw std::invalid_argument("Fail to read the calibration tables!");
+    if (!iSortWrapper.init()) throw std::invalid_argument("Fail to init the ion sorter!");
+    if (!eSortWrapper.init()) throw std::invalid_argument("Fail to init the electron sorter!");
+  }
+
+  // Generate the events
+  Analysis::LMFGenerator generator(reader, "generator");
+  generator.addDetector(reader, "ion_sorter");
+  generator.addDetector(reader, "electron_sorter");
+  generator.setShifts(aLMFWrapper);
+  if (!generator.write(aLMFWrapper.filenames[0])) return 1;
+
+  std::vector<BenchResult> results;
+
+  // ReadNextEvent, convertTDC and sort in the order of sp8sort
+  enum {stageDecode, stageConvertTDC, stageSort};
+  Analysis::StageTimer timer({"ReadNextEvent", "convertTDC", "sort"});
+  std::vector<Analysis::SortRun::DataSet> ionHits, elecHits;
+  std::vector<int> ionNums, elecNums;
+  {
+    if (!aLMFWrapper.readFile(0)) return 1;
+    std::cout << "Sorting the generated events... " << std::endl;
+    unsigned __int64 lastBytePosition = aLMFWrapper.pLMF->input_lmf->tell();
+    timer.reset();
+    while (true) {
+      timer.mark();
+      if (!aLMFWrapper.readNextEvent()) break;
+      const unsigned __int64 bytePosition = aLMFWrapper.pLMF->input_lmf->tell();
+      timer.countEvent(double(bytePosition - lastBytePosition));
+      lastBytePosition = bytePosition;
+      timer.lap(stageDecode);
+
+      aLMFWrapper.convertTDC();
+      iSortWrapper.convertTDC();
+      eSortWrapper.convertTDC();
+      timer.lap(stageConvertTDC);
+
+      iSortWrapper.sort();
+      eSortWrapper.sort();
+      timer.lap(stageSort);
+
+      // keep the sorted hits for the analysis stages
+      for (auto p: {std::make_pair(&iSortWrapper, &ionHits), std::make_pair(&eSortWrapper, &elecHits)}) {
+        const auto &wrapper = *p.first;
+        const int n = wrapper.getNumHits();
+        for (int i = 0; i < n; i++) {
+          p.second->push_back({*wrapper.getNthX(i), *wrapper.getNthY(i),
+                               *wrapper.getNthT(i), *wrapper.getNthMethod(i)});
+        }
+      }
+      ionNums.push_back(iSortWrapper.getNumHits());
+      elecNums.push_back(eSortWrapper.getNumHits());
+    }
+    aLMFWrapper.cleanup();
+    timer.report(std::cout, true);
+    const long n = timer.getEvents();
+    results.push_back({"ReadNextEvent", n, timer.getSeconds(stageDecode)});
+    results.push_back({"convertTDC", n, timer.getSeconds(stageConvertTDC)});
+    results.push_back({"sort", n, timer.getSeconds(stageSort)});
+  }
+
+  if (numDecoderGroups > 0) { // the decoding has to stay bit-exact
+    long numWords;
+    const auto start = Clock::now();
+    const long numMismatches = checkTDC8HPDecoder(numDecoderGroups, pSeed ? (unsigned long long) *pSeed : 1, &numWords);
+    std::cout << "TDC8HP group-mode decoder: " << numDecoderGroups << " groups, " << numWords << " words, "
+              << numMismatches << " differ from the reference (" << secondsSince(start) << " s)" << std::endl;
+    if (numMismatches > 0) return 1;
+  }
+
+  { // Hist::fill2d with TH2D and with the deferred accumulators
+    std::vector<double> xs, ys;
+    for (const auto &hit: ionHits) {
+      xs.push_back(hit.x);
+      ys.push_back(hit.y);
+    }
+    for (const auto &hit: elecHits) {
+      xs.push_back(hit.x);
+      ys.push_back(hit.y);
+    }
+    if (xs.empty()) {
+      xs.push_back(0);
+      ys.push_back(0);
+    }
+    const size_t numPoints = xs.size();
+    Analysis::Hist hist(false, 2);
+    hist.openRootFile("BenchHist.root", "RECREATE");
+    hist.create2d(0, "h2_fill", "x", "y", 500, -100, 100, 500, -100, 100);
+    hist.setDeferred2d(true);
+    hist.create2d(1, "h2_fillDeferred", "x", "y", 500, -100, 100, 500, -100, 100);
+    for (const int id: {0, 1}) {
+      const auto start = Clock::now();
+      for (long i = 0; i < numHistFills; i++) {
+        const size_t k = size_t(i) % numPoints;
+        hist.fill2d(id, xs[k], ys[k]);
+      }
+      results.push_back({id == 0 ? "Hist::fill2d" : "Hist::fill2d_deferred", numHistFills, secondsSince(start)});
+    }
+  }
+
+  // calculateMomentumZ and processEvent on the sorted hits
+  if (pAnaConfig) {
+    std::string rootFilename;
+    { // the intermediate tree of sp8sort
+      Analysis::SortRun run("Bench", maxIonHits, maxElecHits, true);
+      rootFilename = run.getRootFilename();
+      size_t iIon = 0, iElec = 0;
+      for (size_t i = 0; i < ionNums.size(); i++) {
+        const int nIon = std::min(ionNums[i], maxIonHits);
+        const int nElec = std::min(elecNums[i], maxElecHits);
+        if (nIon > 0 && nElec > 0) run.fillTree(nIon, &ionHits[iIon], nElec, &elecHits[iElec]);
+        iIon += ionNums[i];
+        iElec += elecNums[i];
+      }
+    }
+
+    // the input of the analysis config is replaced with the tree above,
+    // the first doc which has a key wins
+    Analysis::JSONReader anaReader;
+    {
+      std::ostringstream str;
+      str << "{\"setup_input\": {"
+          << "\"filenames\": \"" << rootFilename << "\", "
+          << "\"tree_name\": \"resortedData\", "
+          << "\"max_number_of_ion_hits\": " << maxIonHits << ", "
+          << "\"max_number_of_electron_hits\": " << maxElecHits << ", "
+          << "\"is_having_number_of_hits\": true}, "
+          << "\"setup_output\": {\"filename_prefix\": \"Bench\"}}";
+      anaReader.appendDoc(Analysis::JSONReader::fromStr, str.str());
+      anaReader.appendDoc(Analysis::JSONReader::fromFile, *pAnaConfig);
+      const auto base = anaReader.getOpt<const char *>("base_config_file");
+      if (base) anaReader.appendDoc(Analysis::JSONReader::fromFile, *base);
+    }
+
+    { // calculateMomentumZ
+      Analysis::AnalysisTools tools(Analysis::kUnit, anaReader);
+      Analysis::Objects ions(Analysis::Objects::ions, maxIonHits, anaReader, "ions.");
+      Analysis::EventDataReader eventReader(maxIonHits, maxElecHits);
+      long ops = 0;
+      double seconds = 0;
+      volatile double sink = 0; // keeps the results alive
+      size_t iIon = 0;
+      for (size_t i = 0; i < ionNums.size(); i++) {
+        const int n = std::min(ionNums[i], maxIonHits);
+        eventReader.setNumObjs(Analysis::EventDataReader::IonNum) = n;
+        for (int k = 0; k < maxIonHits; k++) {
+          Analysis::SortRun::DataSet hit = {NAN, NAN, NAN, -1};
+          if (k < n) hit = ionHits[iIon + k];
+          eventReader.setEventDataAt(Analysis::EventDataReader::IonX, k) = hit.x;
+          eventReader.setEventDataAt(Analysis::EventDataReader::IonY, k) = hit.y;
+          eventReader.setEventDataAt(Analysis::EventDataReader::IonT, k) = hit.t;
+          eventReader.setFlagDataAt(Analysis::EventDataReader::IonFlag, k) = hit.flag;
+        }
+        iIon += ionNums[i];
+        ions.resetEventData();
+        tools.loadEventDataInputer(ions, eventReader);
+        const int m = ions.getNumberOfRealOrDummyObjects();
+        const auto start = Clock::now();
+        for (int r = 0; r < numMomentumRepeats; r++) {
+          for (int k = 0; k < m; k++) {
+            bool info;
+            sink += tools.calculateMomentumZ(ions.getRealOrDummyObject(k), info);
+          }
+        }
+        seconds += secondsSince(start);
+        ops += long(m) * numMomentumRepeats;
+      }
+      results.push_back({"calculateMomentumZ", ops, seconds});
+    }
+
+    { // processEvent
+      Analysis::AnalysisRun run(anaReader);
+      const long n = run.getEntries();
+      const auto start = Clock::now();
+      for (long i = 0; i < n; i++) run.processEvent(i);
+      results.push_back({"AnalysisRun::processEvent", n, secondsSince(start)});
+    }
+  }
+
+  // Results
+  std::cout << "Results:" << std::endl;
+  for (const auto &r: results) printResult(r);
+  if (!writeResults(resultFilename, generator.getNumEvents(), generator.getNumDetectors(), results, timer.toJSON())) {
+    std::cout << "Could not write " << resultFilename << std::endl;
+    return 1;
+  }
+  std::cout << "The results are written to " << resultFilename << std::endl;
+  return 0;
+}
@@ -23,21 +23,11 @@ class Flag {
   virtual void resetFlag();
 
  protected:
-  const unsigned int get1stDigit(const unsigned int f) const;
-  const unsigned int get1stDigit() const;
-  const unsigned int get2ndDigit(const unsigned int f) const;
-  const unsigned int get2ndDigit() const;
-  const unsigned int get3rdDigit(const unsigned int f) const;
-  const unsigned int get3rdDigit() const;
-  const unsigned int getNthDigit(const unsigned int nth, const unsigned int f) const;
-  const unsigned int getNthDigit(const unsigned int nth) const;
-  const unsigned int getNthNumDigit(const unsigned int nth, const unsigned int num, const unsigned int f) const;
-  const unsigned int getNthNumDigit(const unsigned int nth, const unsigned int num) const;
-  void set1stDigit(const unsigned int f1);
-  void set2ndDigit(const unsigned int f1);
-  void set3ndDigit(const unsigned int f1);
-  void setNthDigit(const unsigned int nth, const unsigned int f1);
-  void setNthNumDigit(const unsigned int nth, const unsigned int num, const unsigned int f1);
+  // a field is 'width' bits starting at bit 'shift'
+  const unsigned int getMaskOfBitField(const unsigned int shift, const unsigned int width) const;
+  const unsigned int getBitField(const unsigned int shift, const unsigned int width, const unsigned int f) const;
+  const unsigned int getBitField(const unsigned int shift, const unsigned int width) const;
+  void setBitField(const unsigned int shift, const unsigned int width, const unsigned int f1);
 };
 }
 
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
 #include "Hist.h"
 
 Analysis::Hist::Hist(const bool verbose, int size)
@@ -9,12 +12,21 @@ Analysis::Hist::Hist(const bool verbose, int size)
   arraySize = size;
   ppHistArray = new TObject *[arraySize];
   for (int i = 0; i < arraySize; ++i) ppHistArray[i] = 0;
+  optionForDeferred2d = false;
+  ppAccArray = new Accumulator2d *[arraySize];
+  for (int i = 0; i < arraySize; ++i) ppAccArray[i] = nullptr;
+  snapshotInterval = 0;
 }
 Analysis::Hist::~Hist() {
   if (ppHistArray) {
     delete[] ppHistArray;
     ppHistArray = nullptr;
   }
+  if (ppAccArray) {
+    for (int i = 0; i < arraySize; ++i) delete ppAccArray[i];
+    delete[] ppAccArray;
+    ppAccArray = nullptr;
+  }
   printf("Closing root file... ");
   if (pRootFile) {
     pRootFile->Close();
@@ -26,8 +38,7 @@ Analysis::Hist::~Hist() {
 void Analysis::Hist::openRootFile(const TString name, const TString arg) {
   pRootFile = TFile::Open(name.Data(), arg.Data());
   if (!pRootFile) {
-    std::cout << " could not be opened, please delete the file!" << std::endl;
-    exit(1);
+    throw std::invalid_argument("The root file " + std::string(name.Data()) + " could not be opened, please delete the file!");
   }
   if (optionForVerbose)
     std::cout << "Histograms will be written to: " << name << std::endl;
@@ -37,6 +48,13 @@ void Analysis::Hist::resetAll() {
   //--write histos to directory--//
   pRootFile->cd();
   for (int i = 0; i < arraySize; ++i) {
+    Accumulator2d *acc = ppAccArray[i];
+    if (acc) {
+      acc->sumw.clear();
+      acc->sumw2.clear();
+      acc->entries = 0;
+      for (double &s : acc->stats) s = 0;
+    }
     TObject *obj = ppHistArray[i];
     if (obj) {
 
@@ -53,6 +71,10 @@ void Analysis::Hist::resetAll() {
 }
 void Analysis::Hist::flushRootFile() {
   if (optionForVerbose) std::cout << "flushing root file" << std::endl;
+  //--create the hists which are still in accumulators--//
+  for (int i = 0; i < arraySize; ++i) {
+    if (ppAccArray[i]) materialize2d(i);
+  }
   //--write histos to directory--//
   pRootFile->cd();
   for (int i = 0; i < arraySize; ++i) {
@@ -189,8 +211,118 @@ void Analysis::Hist::fill2d(const int id,
                             const double fillX,
                             const double fillY,
                             const double weight) {
+  if (ppAccArray[id]) {
+    fillAccumulator2d(*ppAccArray[id], fillX, fillY, weight);
+    return;
+  }
   dynamic_cast<TH2D *>(ppHistArray[id])->Fill(fillX, fillY, weight);
 }
+void Analysis::Hist::fillAccumulator2d(Accumulator2d &acc,
+                                       const double fillX,
+                                       const double fillY,
+                                       const double weight) {
+  // same binning and statistics as TH2::Fill
+  const int nX = acc.nXbins, nY = acc.nYbins;
+  if (acc.sumw.empty()) acc.sumw.resize((unsigned long) ((nX + 2) * (nY + 2)), 0);
+  acc.entries++;
+  int binX, binY;
+  if (fillX < acc.xLow) binX = 0;
+  else if (!(fillX < acc.xUp)) binX = nX + 1;
+  else binX = 1 + (int) (nX * (fillX - acc.xLow) / (acc.xUp - acc.xLow));
+  if (fillY < acc.yLow) binY = 0;
+  else if (!(fillY < acc.yUp)) binY = nY + 1;
+  else binY = 1 + (int) (nY * (fillY - acc.yLow) / (acc.yUp - acc.yLow));
+  const int bin = binY * (nX + 2) + binX;
+  if (acc.sumw2.empty() && weight != 1) acc.sumw2 = acc.sumw;
+  if (!acc.sumw2.empty()) acc.sumw2[bin] += weight * weight;
+  acc.sumw[bin] += weight;
+  if (binX == 0 || binX > nX || binY == 0 || binY > nY) return;
+  acc.stats[0] += weight;
+  acc.stats[1] += weight * weight;
+  acc.stats[2] += weight * fillX;
+  acc.stats[3] += weight * fillX * fillX;
+  acc.stats[4] += weight * fillY;
+  acc.stats[5] += weight * fillY * fillY;
+  acc.stats[6] += weight * fillX * fillY;
+}
+void Analysis::Hist::materialize2d(const int id) {
+  Accumulator2d *acc = ppAccArray[id];
+  if (!acc) return;
+  ppAccArray[id] = nullptr;
+  TH2D *h = newHist2d(id, acc->name.c_str(), acc->titleX.c_str(), acc->titleY.c_str(),
+                      acc->nXbins, acc->xLow, acc->xUp,
+                      acc->nYbins, acc->yLow, acc->yUp,
+                      acc->dir.c_str());
+  if (!acc->sumw.empty()) {
+    std::copy(acc->sumw.begin(), acc->sumw.end(), h->GetArray());
+    if (!acc->sumw2.empty()) {
+      h->Sumw2();
+      std::copy(acc->sumw2.begin(), acc->sumw2.end(), h->GetSumw2()->GetArray());
+    }
+    h->PutStats(acc->stats);
+    h->SetEntries(acc->entries);
+  }
+  delete acc;
+}
+void Analysis::Hist::setSnapshot(const std::string filename, const double interval) {
+  if (interval < 0) throw std::invalid_argument("The snapshot interval is invalid!");
+  snapshotFilename = filename;
+  snapshotInterval = interval;
+  lastSnapshot = std::chrono::steady_clock::now();
+}
+bool Analysis::Hist::publishSnapshot(const bool force) {
+  if (snapshotFilename.empty()) return false;
+  const auto now = std::chrono::steady_clock::now();
+  if (!force && std::chrono::duration<double>(now - lastSnapshot).count() < snapshotInterval) return false;
+  lastSnapshot = now;
+
+  // written to a temporary file and renamed, so the viewer never sees a half written file
+  TDirectory *saveDir = gDirectory;
+  const std::string tmpFilename = snapshotFilename + ".tmp";
+  TFile *pSnapshot = TFile::Open(tmpFilename.c_str(), "RECREATE", "", 0);
+  if (!pSnapshot) {
+    saveDir->cd();
+    return false;
+  }
+  const bool addDir = TH1::AddDirectoryStatus();
+  TH1::AddDirectory(false);
+  for (int i = 0; i < arraySize; ++i) {
+    TH1 *h = (TH1 *) ppHistArray[i];
+    const Accumulator2d *acc = ppAccArray[i];
+    if (h) {
+      std::string dir = h->GetDirectory() ? h->GetDirectory()->GetPath() : "";
+      const size_t pos = dir.find(":/");
+      dir = pos == std::string::npos ? "" : dir.substr(pos + 2);
+      (dir.empty() ? (TDirectory *) pSnapshot : getDir(pSnapshot, dir.c_str()))->WriteTObject(h);
+    } else if (acc) { // a detached copy, the accumulator keeps filling
+      TH2D h2(acc->name.c_str(), acc->name.c_str(), acc->nXbins, acc->xLow, acc->xUp, acc->nYbins, acc->yLow, acc->yUp);
+      h2.SetOption("colz");
+      h2.SetXTitle(acc->titleX.c_str());
+      h2.SetYTitle(acc->titleY.c_str());
+      if (!acc->sumw.empty()) {
+        std::copy(acc->sumw.begin(), acc->sumw.end(), h2.GetArray());
+        if (!acc->sumw2.empty()) {
+          h2.Sumw2();
+          std::copy(acc->sumw2.begin(), acc->sumw2.end(), h2.GetSumw2()->GetArray());
+        }
+        h2.PutStats(const_cast<double *>(acc->stats));
+        h2.SetEntries(acc->entries);
+      }
+      (acc->dir.empty() ? (TDirectory *) pSnapshot : getDir(pSnapshot, acc->dir.c_str()))->WriteTObject(&h2);
+    }
+  }
+  TH1::AddDirectory(addDir);
+  pSnapshot->Close();
+  delete pSnapshot;
+  saveDir->cd();
+  return std::rename(tmpFilename.c_str(), snapshotFilename.c_str()) == 0;
+}
+void Analysis::Hist::setDeferred2d(const bool deferred) {
+  optionForDeferred2d = deferred;
+}
+const bool Analysis::Hist::isDeferred2d() const {
+  return optionForDeferred2d;
+}
 void Analysis::Hist::plot2d(int id, int binX, int binY, double content) {
   dynamic_cast<TH2D *>(ppHistArray[id])->SetBinContent(binX, binY, content);
 }
@@ -202,7 +334,35 @@ TH1 *Analysis::Hist::create2d(int id, const char *name,
   //check if hist already exists, if so return it//
   pHist2 = dynamic_cast<TH2D *>(ppHistArray[id]);
   if (pHist2) return pHist2;
+  if (ppAccArray[id]) return nullptr;
 
+  //--keep only the binning until it is needed--//
+  if (optionForDeferred2d) {
+    Accumulator2d *acc = new Accumulator2d;
+    acc->name = name;
+    acc->titleX = titleX;
+    acc->titleY = titleY;
+    acc->dir = dir;
+    acc->nXbins = nXbins;
+    acc->xLow = xLow;
+    acc->xUp = xUp;
+    acc->nYbins = nYbins;
+    acc->yLow = yLow;
+    acc->yUp = yUp;
+    acc->entries = 0;
+    for (double &s : acc->stats) s = 0;
+    ppAccArray[id] = acc;
+    if (optionForVerbose)
+      std::cout << "create deferred 2D: " << dir << "/" << name << std::endl;
+    return nullptr;
+  }
+  return newHist2d(id, name, titleX, titleY, nXbins, xLow, xUp, nYbins, yLow, yUp, dir);
+}
+TH2D *Analysis::Hist::newHist2d(int id, const char *name,
+                                const char *titleX, const char *titleY,
+                                int nXbins, double xLow, double xUp,
+                                int nYbins, double yLow, double yUp,
+                                const char *dir) {
   TDirectory *saveDir = gDirectory;        //save a pointer to the current directory
   getDir(pRootFile, dir)->cd();                //change to directory that this histo need to be created in
 
@@ -294,6 +454,7 @@ TH3 *Analysis::Hist::getHist3d(int id) const {
   return dynamic_cast<TH3 *>(ppHistArray[id]);
 }
 TH2 *Analysis::Hist::getHist2d(int id) const {
+  if (ppAccArray[id]) const_cast<Hist *>(this)->materialize2d(id);
   return dynamic_cast<TH2 *>(ppHistArray[id]);
 }
 TH1 *Analysis::Hist::getHist1d(int id) const {
@@ -2,6 +2,9 @@
 #define ANALYSIS_OUTPUTHIST_H
 
 #include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
 #include <TFile.h>
 #include <TTree.h>
 #include <TGraph.h>
@@ -24,6 +27,35 @@ class Hist {
   TObject **ppHistArray;
   const bool optionForVerbose;
 
+ private:
+  // a 2d hist which is filled without ROOT, it is converted to TH2D when it is needed
+  struct Accumulator2d {
+    std::string name, titleX, titleY, dir;
+    int nXbins;
+    double xLow, xUp;
+    int nYbins;
+    double yLow, yUp;
+    std::vector<double> sumw, sumw2; // allocated at the first fill
+    double entries;
+    double stats[7]; // sumw, sumw2, sumwx, sumwx2, sumwy, sumwy2, sumwxy
+  };
+  Accumulator2d **ppAccArray;
+  bool optionForDeferred2d;
+  TH2D *newHist2d(int id, const char *name,
+                  const char *titleX, const char *titleY,
+                  int nXbins, double xLow, double xUp,
+                  int nYbins, double yLow, double yUp,
+                  const char *dir);
+  void fillAccumulator2d(Accumulator2d &acc,
+                         const double fillX, const double fillY,
+                         const double weight);
+  void materialize2d(const int id);
+
+ private:
+  std::string snapshotFilename;
+  double snapshotInterval; // [s]
+  std::chrono::steady_clock::time_point lastSnapshot;
+
  public:
   Hist(const bool verbose = false, int NbrMaxHistos = 100000);
   virtual ~Hist();
@@ -34,6 +66,14 @@ class Hist {
   void openRootFile(const TString name, const TString arg="RECREATE");
   void linkRootFile(TFile &RootFile);
   const bool isVerbose() const;
+  // 2d hists created after this is set will be filled to compact accumulators,
+  // and TH2Ds will be created at flushRootFile or getHist2d
+  void setDeferred2d(const bool deferred);
+  const bool isDeferred2d() const;
+  // live snapshots: all hists are copied to a separate root file at most every interval,
+  // a viewer process reads it instead of canvases drawn in the processing loop
+  void setSnapshot(const std::string filename, const double interval);
+  bool publishSnapshot(const bool force = false);
 
   // 1d hist
   TH1 *create1d(int id, const char *name,
@@ -158,3 +158,46 @@ const rapidjson::Value *Analysis::JSONReader::getOptValue(const std::string str1
         return getOptValue(tmp1, &(*v)[tmp0.c_str()], appendKw(str0, tmp0));
 	}
 }
+namespace {
+void mergeValue(rapidjson::Value &dst, const rapidjson::Value &src, rapidjson::Document::AllocatorType &alloc) {
+  if (!dst.IsObject() || !src.IsObject()) {
+    dst.CopyFrom(src, alloc);
+    return;
+  }
+  for (auto &m: src.GetObject()) {
+    auto it = dst.FindMember(m.name);
+    if (it != dst.MemberEnd()) {
+      mergeValue(it->value, m.value, alloc);
+      continue;
+    }
+    rapidjson::Value name(m.name, alloc), value(m.value, alloc);
+    dst.AddMember(name, value, alloc);
+  }
+}
+}
+Analysis::JSONReader *Analysis::JSONReader::createPatched(const rapidjson::Value &patch) const {
+  if (!patch.IsObject()) throw std::invalid_argument("The patch must be an object!");
+  auto *pPatched = new rapidjson::Document;
+  pPatched->SetObject();
+  auto &alloc = pPatched->GetAllocator();
+  for (auto &m: patch.GetObject()) {
+    rapidjson::Value value;
+    const auto pBase = getOptValue(m.name.GetString());
+    if (pBase != nullptr) {
+      value.CopyFrom(*pBase, alloc);
+      mergeValue(value, m.value, alloc);
+    } else {
+      value.CopyFrom(m.value, alloc);
+    }
+    rapidjson::Value name(m.name, alloc);
+    pPatched->AddMember(name, value, alloc);
+  }
+  auto *pReader = new JSONReader();
+  pReader->ReadFromDoc(pPatched);
+  for (auto pDoc: pDocs) { // the readers own their docs
+    auto *pCopy = new rapidjson::Document;
+    pCopy->CopyFrom(*pDoc, pCopy->GetAllocator());
+    pReader->ReadFromDoc(pCopy);
+  }
+  return pReader;
+}
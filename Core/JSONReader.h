@@ -25,6 +25,9 @@ class JSONReader {
   JSONReader(const ReadingType type=DoNothing, const std::string str="", const rapidjson::Document *pDoc=nullptr);
   ~JSONReader();
   void appendDoc(const ReadingType type, const std::string str="", const rapidjson::Document *pDoc=nullptr);
+  // a new reader of the same docs with the members of the patch object overwritten,
+  // objects are merged member by member, {"ion_sorter": {"factors": {"fu": 0.6}}} changes only fu
+  JSONReader *createPatched(const rapidjson::Value &patch) const;
 
  private:
   bool hasMember(const std::string str, const rapidjson::Value *&pV) const;
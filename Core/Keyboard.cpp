@@ -0,0 +1,18 @@
+#include "Keyboard.h"
+#include <cstdio>
+#include <termios.h>
+
+int Analysis::kbhit() {
+  const int fd = 0;
+  struct termios term, oterm;
+  tcgetattr(fd, &oterm);
+  term = oterm;
+  term.c_lflag &= ~ICANON;
+  term.c_cc[VMIN] = 0;
+  term.c_cc[VTIME] = 1;
+  tcsetattr(fd, TCSANOW, &term);
+  const int c = getchar();
+  tcsetattr(fd, TCSANOW, &oterm);
+  if (c == EOF) return 0;
+  return c;
+}
@@ -0,0 +1,10 @@
+#ifndef ANALYSIS_KEYBOARD_H
+#define ANALYSIS_KEYBOARD_H
+
+namespace Analysis {
+// The key hit on the terminal within 0.1 s, 0 without one. Only the canonical mode
+// is switched off while waiting, the other terminal flags are kept.
+int kbhit();
+}
+
+#endif //ANALYSIS_KEYBOARD_H
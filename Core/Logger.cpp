@@ -0,0 +1,73 @@
+#include "Logger.h"
+#include <vector>
+#include <stdexcept>
+#include "spdlog/async_logger.h"
+#include "spdlog/sinks/file_sinks.h"
+#include "spdlog/sinks/stdout_sinks.h"
+
+Analysis::LoggerConfig Analysis::readLoggerConfig(const Analysis::JSONReader &reader,
+                                                  const std::string prefix,
+                                                  Analysis::LoggerConfig config) {
+  if (!reader.hasMember(prefix)) return config;
+  const auto pFile = reader.getOpt<const char *>(prefix + ".file");
+  if (pFile) config.filename = *pFile;
+  const auto pLevel = reader.getOpt<const char *>(prefix + ".level");
+  if (pLevel) {
+    const std::string level = *pLevel;
+    if (level == "trace") config.level = spdlog::level::trace;
+    else if (level == "debug") config.level = spdlog::level::debug;
+    else if (level == "info") config.level = spdlog::level::info;
+    else if (level == "warning") config.level = spdlog::level::warn;
+    else if (level == "error") config.level = spdlog::level::err;
+    else if (level == "critical") config.level = spdlog::level::critical;
+    else if (level == "off") config.level = spdlog::level::off;
+    else throw std::invalid_argument("Invalid log level: " + level);
+  }
+  const auto pMaxSize = reader.getOpt<double>(prefix + ".max_size");
+  if (pMaxSize) {
+    if (*pMaxSize <= 0) throw std::invalid_argument("The max size of the log file is invalid!");
+    config.maxSize = (size_t) (*pMaxSize * 1024 * 1024);
+  }
+  const auto pMaxFiles = reader.getOpt<int>(prefix + ".max_files");
+  if (pMaxFiles) {
+    if (*pMaxFiles < 1) throw std::invalid_argument("The number of the log files is invalid!");
+    config.maxFiles = (size_t) *pMaxFiles;
+  }
+  return config;
+}
+std::shared_ptr<spdlog::logger> Analysis::createLogger(const std::string name, const Analysis::LoggerConfig &config) {
+  std::vector<spdlog::sink_ptr> sinks;
+  if (!config.filename.empty()) {
+    sinks.push_back(std::make_shared<spdlog::sinks::rotating_file_sink_mt>(config.filename,
+                                                                          config.maxSize, config.maxFiles));
+  }
+  if (config.isConsole) {
+    if (config.isStderr) sinks.push_back(std::make_shared<spdlog::sinks::stderr_sink_mt>());
+    else sinks.push_back(std::make_shared<spdlog::sinks::stdout_sink_mt>());
+  }
+  // block and retry when the queue is full, the messages are never dropped
+  auto pLogger = std::make_shared<spdlog::async_logger>(name, sinks.begin(), sinks.end(), config.queueSize);
+  pLogger->set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%n] [%l] %v");
+  pLogger->set_level(config.level);
+  pLogger->flush_on(spdlog::level::err);
+  return pLogger;
+}
+
+Analysis::LogStream::LineBuf::LineBuf(std::shared_ptr<spdlog::logger> p) : pLogger(p) {}
+Analysis::LogStream::LineBuf::~LineBuf() {
+  const std::string rest = str();
+  if (!rest.empty()) pLogger->info(rest);
+}
+int Analysis::LogStream::LineBuf::sync() {
+  // std::endl ends here, the complete lines are sent and the rest is kept
+  const std::string s = str();
+  size_t begin = 0, end;
+  while ((end = s.find('\n', begin)) != std::string::npos) {
+    if (end > begin) pLogger->info(s.substr(begin, end - begin));
+    begin = end + 1;
+  }
+  str(s.substr(begin));
+  pubseekoff(0, std::ios_base::end, std::ios_base::out);
+  return 0;
+}
+Analysis::LogStream::LogStream(std::shared_ptr<spdlog::logger> p) : std::ostream(&buf), buf(p) {}
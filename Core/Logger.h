@@ -0,0 +1,43 @@
+#ifndef ANALYSIS_LOGGER_H
+#define ANALYSIS_LOGGER_H
+
+#include <string>
+#include <sstream>
+#include <memory>
+#include "spdlog/spdlog.h"
+#include "JSONReader.h"
+
+namespace Analysis {
+// Async loggers of the executables: a message is formatted on the caller thread and
+// written to the console and a rotating log file by the worker thread of the logger,
+// so the event loops never wait for the disk. Every line carries the time, the level
+// and the logger name, which is the run it belongs to.
+struct LoggerConfig {
+  std::string filename; // empty=no log file
+  spdlog::level::level_enum level = spdlog::level::info;
+  size_t maxSize = 10 * 1024 * 1024; // [bytes] of a log file before it is rotated
+  size_t maxFiles = 3; // rotated log files kept
+  bool isConsole = false;
+  bool isStderr = false; // the console messages go to stderr instead of stdout
+  size_t queueSize = 8192; // messages, a power of 2
+};
+// {"file": "sp8sort.log", "level": "info", "max_size": 10.0, "max_files": 3}, max_size in MB
+LoggerConfig readLoggerConfig(const JSONReader &reader, const std::string prefix, LoggerConfig config);
+std::shared_ptr<spdlog::logger> createLogger(const std::string name, const LoggerConfig &config);
+
+// Sends every line written by << to a logger, for the writers which are used as streams
+class LogStream: public std::ostream {
+  class LineBuf: public std::stringbuf {
+    std::shared_ptr<spdlog::logger> pLogger;
+   protected:
+    int sync() override;
+   public:
+    LineBuf(std::shared_ptr<spdlog::logger> p);
+    ~LineBuf();
+  } buf;
+ public:
+  LogStream(std::shared_ptr<spdlog::logger> p);
+};
+}
+
+#endif //ANALYSIS_LOGGER_H
@@ -0,0 +1,89 @@
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include "StageTimer.h"
+
+Analysis::StageTimer::StageTimer(const std::vector<std::string> stageNames, const double interval)
+    : names(stageNames), reportInterval(interval) {
+  reset();
+}
+void Analysis::StageTimer::reset() {
+  seconds.assign(names.size(), 0);
+  events = 0;
+  bytes = 0;
+  startTime = Clock::now();
+  markTime = startTime;
+  lastReportTime = startTime;
+  lastReportEvents = 0;
+  lastReportBytes = 0;
+}
+void Analysis::StageTimer::mark() {
+  markTime = Clock::now();
+}
+void Analysis::StageTimer::lap(const int stage) {
+  const auto now = Clock::now();
+  seconds[stage] += std::chrono::duration<double>(now - markTime).count();
+  markTime = now;
+}
+void Analysis::StageTimer::countEvent(const double numBytes) {
+  events++;
+  bytes += numBytes;
+}
+bool Analysis::StageTimer::report(std::ostream &out, const bool force) {
+  const auto now = Clock::now();
+  const double dt = std::chrono::duration<double>(now - lastReportTime).count();
+  if (!force && dt < reportInterval) return false;
+  const double total = getElapsed();
+  double busy = 0;
+  for (const double s: seconds) busy += s;
+  out << std::fixed << std::setprecision(1)
+      << "[timing] " << events << " events, "
+      << (dt > 0 ? (events - lastReportEvents) / dt : 0) << " events/s, "
+      << (dt > 0 ? (bytes - lastReportBytes) / dt / 1e6 : 0) << " MB/s |";
+  for (size_t i = 0; i < names.size(); i++) {
+    out << " " << names[i] << " " << (busy > 0 ? 100 * seconds[i] / busy : 0) << "%";
+  }
+  out << " | " << total << " s" << std::endl;
+  out.unsetf(std::ios_base::floatfield);
+  lastReportTime = now;
+  lastReportEvents = events;
+  lastReportBytes = bytes;
+  return true;
+}
+const std::string Analysis::StageTimer::toJSON() const {
+  const double total = getElapsed();
+  std::ostringstream out;
+  out << std::setprecision(9);
+  out << "{\n";
+  out << "  \"elapsed_s\": " << total << ",\n";
+  out << "  \"events\": " << events << ",\n";
+  out << "  \"bytes\": " << bytes << ",\n";
+  out << "  \"events_per_s\": " << (total > 0 ? events / total : 0) << ",\n";
+  out << "  \"MB_per_s\": " << (total > 0 ? bytes / total / 1e6 : 0) << ",\n";
+  out << "  \"stages\": {";
+  for (size_t i = 0; i < names.size(); i++) {
+    out << (i == 0 ? "\n" : ",\n");
+    out << "    \"" << names[i] << "\": {"
+        << "\"seconds\": " << seconds[i] << ", "
+        << "\"fraction\": " << (total > 0 ? seconds[i] / total : 0) << ", "
+        << "\"ns_per_event\": " << (events > 0 ? 1e9 * seconds[i] / events : 0) << "}";
+  }
+  out << "\n  }\n";
+  out << "}\n";
+  return out.str();
+}
+bool Analysis::StageTimer::writeJSON(const std::string filename) const {
+  std::ofstream file(filename);
+  if (!file) return false;
+  file << toJSON();
+  return (bool) file;
+}
+double Analysis::StageTimer::getSeconds(const int stage) const {
+  return seconds[stage];
+}
+long Analysis::StageTimer::getEvents() const {
+  return events;
+}
+double Analysis::StageTimer::getElapsed() const {
+  return std::chrono::duration<double>(Clock::now() - startTime).count();
+}
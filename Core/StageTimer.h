@@ -0,0 +1,42 @@
+#ifndef ANALYSIS_STAGETIMER_H
+#define ANALYSIS_STAGETIMER_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace Analysis {
+// Accumulates the wall time spent in the stages of an event loop.
+// mark() starts a lap and lap(stage) books the time since the last mark
+// to the stage, so one clock read is needed per stage boundary.
+class StageTimer {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+ private:
+  std::vector<std::string> names;
+  std::vector<double> seconds;
+  long events;
+  double bytes;
+  const double reportInterval;
+  Clock::time_point startTime, markTime, lastReportTime;
+  long lastReportEvents;
+  double lastReportBytes;
+
+ public:
+  StageTimer(const std::vector<std::string> stageNames, const double interval = 10);
+  void reset();
+  void mark();
+  void lap(const int stage);
+  void countEvent(const double numBytes = 0);
+  bool report(std::ostream &out, const bool force = false);
+  const std::string toJSON() const;
+  bool writeJSON(const std::string filename) const;
+  long getEvents() const;
+  double getSeconds(const int stage) const;
+  double getElapsed() const;
+};
+}
+
+#endif
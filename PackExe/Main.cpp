@@ -0,0 +1,65 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <sys/stat.h>
+#include "../SortExe/LMFZ.h"
+
+// Converts LMF files to the block-compressed files which sp8sort reads directly, and back.
+
+long long fileSize(const std::string &filename) {
+  struct stat st;
+  if (stat(filename.c_str(), &st) != 0) return -1;
+  return (long long) st.st_size;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 4) {
+    printf("syntax: sp8pack pack LMF_file packed_file [-b block_MB] [-l level] [-j threads]\n");
+    printf("        sp8pack unpack packed_file LMF_file\n");
+    printf("        The packed file is cut into zlib blocks of block_MB (default 4) with level 0-9 (default 6),\n");
+    printf("        sp8sort reads it like the LMF file.\n");
+    return 0;
+  }
+  const std::string cmd = argv[1], in = argv[2], out = argv[3];
+  if (cmd == "pack") {
+    double blockMB = 4;
+    int level = 6, numThreads = 0;
+    for (int i = 4; i + 1 < argc; i += 2) {
+      const std::string opt = argv[i];
+      if (opt == "-b") blockMB = atof(argv[i + 1]);
+      else if (opt == "-l") level = atoi(argv[i + 1]);
+      else if (opt == "-j") numThreads = atoi(argv[i + 1]);
+      else {
+        printf("Unknown option %s\n", opt.c_str());
+        return 1;
+      }
+    }
+    const auto blockSize = (uint32_t) (blockMB * 1024 * 1024);
+    if (blockSize == 0 || blockMB > 1024 || level < 0 || level > 9) {
+      printf("The block size or the level is invalid.\n");
+      return 1;
+    }
+    if (!Analysis::packLMF(in, out, blockSize, level, numThreads)) {
+      std::cout << "Could not pack " << in << std::endl;
+      return 1;
+    }
+    const long long inSize = fileSize(in), outSize = fileSize(out);
+    std::cout << in << " (" << inSize << " bytes) is packed to " << out << " (" << outSize << " bytes, "
+              << (inSize > 0 ? 100.0 * outSize / inSize : 0) << " %)" << std::endl;
+    return 0;
+  }
+  if (cmd == "unpack") {
+    if (!Analysis::LMFZReader::isPacked(in)) {
+      std::cout << in << " is not a packed LMF file." << std::endl;
+      return 1;
+    }
+    if (!Analysis::unpackLMF(in, out)) {
+      std::cout << "Could not unpack " << in << std::endl;
+      return 1;
+    }
+    std::cout << in << " is unpacked to " << out << " (" << fileSize(out) << " bytes)" << std::endl;
+    return 0;
+  }
+  printf("Unknown command %s\n", cmd.c_str());
+  return 1;
+}
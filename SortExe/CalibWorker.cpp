@@ -0,0 +1,126 @@
+#include "CalibWorker.h"
+Analysis::CalibWorker::CalibWorker(sort_class *pMaster, const int numChannels, const int rowLength,
+                                   const double wOffset, const int blockSize)
+    : rowLength(rowLength), wOffset(wOffset), blockSize(blockSize) {
+  if (pMaster == nullptr) throw std::invalid_argument("The sorter is invalid!");
+  chs[0] = pMaster->Cu1;
+  chs[1] = pMaster->Cu2;
+  chs[2] = pMaster->Cv1;
+  chs[3] = pMaster->Cv2;
+  chs[4] = pMaster->use_HEX ? pMaster->Cw1 : -1;
+  chs[5] = pMaster->use_HEX ? pMaster->Cw2 : -1;
+  chs[6] = pMaster->use_MCP ? pMaster->Cmcp : -1;
+  pFilling = nullptr;
+  isBusy = false;
+  isClosing = false;
+  isMapFull = false;
+
+  count.assign((size_t) numChannels, 0);
+  tdcns.assign((size_t) (numChannels * rowLength), 0);
+  pSorter = pMaster->clone();
+  pSorter->count = &count[0];
+  pSorter->tdc_pointer = &tdcns[0];
+  if (pSorter->init_after_setting_parameters()) {
+    delete pSorter;
+    throw std::invalid_argument("Fail to init the calibration worker!");
+  }
+  thread = std::thread(&CalibWorker::run, this);
+}
+Analysis::CalibWorker::~CalibWorker() {
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    isClosing = true;
+  }
+  cvQueued.notify_all();
+  if (thread.joinable()) thread.join();
+  for (auto pBlock: queue) delete pBlock;
+  queue.clear();
+  if (pFilling != nullptr) {
+    delete pFilling;
+    pFilling = nullptr;
+  }
+  if (pSorter != nullptr) {
+    delete pSorter;
+    pSorter = nullptr;
+  }
+}
+void Analysis::CalibWorker::push(const unsigned int *count, const double *tdcns) {
+  if (pFilling == nullptr) {
+    pFilling = new Block;
+    pFilling->numEvents = 0;
+    pFilling->counts.reserve((size_t) (blockSize * numAnodeChs));
+  }
+  for (const int ch: chs) {
+    if (ch < 0) {
+      pFilling->counts.push_back(0);
+      continue;
+    }
+    const int n = std::min((int) count[ch], rowLength);
+    pFilling->counts.push_back(n);
+    const double *p = tdcns + ch * rowLength;
+    pFilling->hits.insert(pFilling->hits.end(), p, p + n);
+  }
+  pFilling->numEvents++;
+  if (pFilling->numEvents >= blockSize) dispatch();
+}
+void Analysis::CalibWorker::dispatch() {
+  if (pFilling == nullptr) return;
+  {
+    // keep the reader at most two blocks ahead
+    std::unique_lock<std::mutex> lock(mtx);
+    cvDone.wait(lock, [this] { return queue.size() < 2; });
+    queue.push_back(pFilling);
+  }
+  pFilling = nullptr;
+  cvQueued.notify_one();
+}
+void Analysis::CalibWorker::run() {
+  while (true) {
+    Block *pBlock;
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      cvQueued.wait(lock, [this] { return isClosing || !queue.empty(); });
+      if (queue.empty()) return;
+      pBlock = queue.front();
+      queue.pop_front();
+      isBusy = true;
+    }
+    cvDone.notify_all();
+    process(pBlock);
+    delete pBlock;
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      isBusy = false;
+    }
+    cvDone.notify_all();
+  }
+}
+void Analysis::CalibWorker::process(const Block *pBlock) {
+  const int *pCount = &pBlock->counts[0];
+  const double *pHit = pBlock->hits.empty() ? nullptr : &pBlock->hits[0];
+  for (int iEvent = 0; iEvent < pBlock->numEvents; iEvent++) {
+    for (const int ch: chs) {
+      const int n = *pCount++;
+      if (ch < 0) continue;
+      count[ch] = n;
+      std::copy(pHit, pHit + n, tdcns.begin() + ch * rowLength);
+      pHit += n;
+    }
+    if (isMapFull) continue;
+    pSorter->feed_calibration_data(true, wOffset);
+    if (pSorter->scalefactors_calibrator != nullptr && pSorter->scalefactors_calibrator->map_is_full_enough()) {
+      isMapFull = true;
+    }
+  }
+}
+void Analysis::CalibWorker::drain() {
+  dispatch();
+  std::unique_lock<std::mutex> lock(mtx);
+  cvDone.wait(lock, [this] { return queue.empty() && !isBusy; });
+}
+bool Analysis::CalibWorker::isFull() const {
+  return isMapFull;
+}
+sort_class *Analysis::CalibWorker::getSorter() const {
+  return pSorter;
+}
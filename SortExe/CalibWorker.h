@@ -0,0 +1,62 @@
+#ifndef ANALYSIS_CALIBWORKER_H
+#define ANALYSIS_CALIBWORKER_H
+
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
+#include "resort64c.h"
+
+namespace Analysis {
+// Feeds the calibration of a sorter on a worker thread. The worker owns a clone of the sorter
+// and calls feed_calibration_data of resort64c for every event in the order of the file, so the
+// detector map and the walk profiles end in the same state as the ones of a serial run. The
+// calibrators keep private maps and stacks which can not be merged, so the events of a detector
+// are not split between threads; the ion and the electron sorters have a worker each.
+class CalibWorker {
+  static const int numAnodeChs = 7; // u1, u2, v1, v2, w1, w2, MCP
+  struct Block {
+    int numEvents;
+    std::vector<int> counts; // numEvents * numAnodeChs
+    std::vector<double> hits;
+  };
+
+  sort_class *pSorter;
+  const int rowLength;
+  const double wOffset;
+  const int blockSize;
+  int chs[numAnodeChs];
+  std::vector<__int32> count;
+  std::vector<double> tdcns;
+  Block *pFilling;
+  std::deque<Block *> queue;
+  bool isBusy;
+  bool isClosing;
+  std::atomic<bool> isMapFull;
+  std::mutex mtx;
+  std::condition_variable cvQueued, cvDone;
+  std::thread thread;
+
+  void dispatch();
+  void run();
+  void process(const Block *pBlock);
+
+ public:
+  // the clone has to be made before the master is initialized
+  CalibWorker(sort_class *pMaster, const int numChannels, const int rowLength,
+              const double wOffset, const int blockSize = 4096);
+  ~CalibWorker();
+  void push(const unsigned int *count, const double *tdcns);
+  void drain();
+  // the detector map is full enough, the later events are not fed like the serial run stops there
+  bool isFull() const;
+  // the calibrated sorter, only after drain()
+  sort_class *getSorter() const;
+};
+}
+
+#endif //ANALYSIS_CALIBWORKER_H
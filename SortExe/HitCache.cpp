@@ -0,0 +1,157 @@
+#include "HitCache.h"
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+size_t countBytes(const size_t numChs) { return (2 * numChs + 3) & ~(size_t) 3; }
+size_t padded(const size_t n) { return (n + 7) & ~(size_t) 7; }
+}
+
+Analysis::HitCacheWriter::HitCacheWriter(const std::string filename, const std::vector<int> chs, const int maxHits,
+                                         const uint64_t lmfSize, const int64_t lmfMtime)
+    : filename(filename), tmpFilename(filename + ".tmp"), file(nullptr), chs(chs), maxHits(maxHits), numEvents(0) {
+  file = fopen(tmpFilename.c_str(), "wb");
+  if (file == nullptr) return;
+  std::vector<char> header(padded(HIT_CACHE_HEADER_SIZE + 4 * chs.size()), 0);
+  const uint32_t numChs = (uint32_t) chs.size(), hits = (uint32_t) maxHits;
+  memcpy(&header[0], HIT_CACHE_MAGIC, 8);
+  memcpy(&header[8], &lmfSize, sizeof(lmfSize));
+  memcpy(&header[16], &lmfMtime, sizeof(lmfMtime));
+  memcpy(&header[24], &numEvents, sizeof(numEvents)); // written again by finish
+  memcpy(&header[32], &numChs, sizeof(numChs));
+  memcpy(&header[36], &hits, sizeof(hits));
+  for (size_t k = 0; k < chs.size(); k++) {
+    const uint32_t ch = (uint32_t) chs[k];
+    memcpy(&header[HIT_CACHE_HEADER_SIZE + 4 * k], &ch, sizeof(ch));
+  }
+  fwrite(header.data(), 1, header.size(), file);
+}
+Analysis::HitCacheWriter::~HitCacheWriter() {
+  if (file == nullptr) return;
+  fclose(file);
+  remove(tmpFilename.c_str());
+}
+bool Analysis::HitCacheWriter::isOpen() const { return file != nullptr; }
+void Analysis::HitCacheWriter::write(const double timestamp, const unsigned int *count, const int *tdc,
+                                     const int rowLength) {
+  if (file == nullptr) return;
+  const size_t nCounts = countBytes(chs.size());
+  record.assign(8 + nCounts, 0);
+  memcpy(&record[0], &timestamp, sizeof(timestamp));
+  for (size_t k = 0; k < chs.size(); k++) {
+    const int ch = chs[k];
+    const uint16_t n = (uint16_t) std::min<unsigned int>(count[ch], (unsigned int) maxHits);
+    memcpy(&record[8 + 2 * k], &n, sizeof(n));
+    const char *p = (const char *) (tdc + ch * rowLength);
+    record.insert(record.end(), p, p + n * sizeof(int32_t));
+  }
+  record.resize(padded(record.size()), 0);
+  fwrite(record.data(), 1, record.size(), file);
+  numEvents++;
+}
+bool Analysis::HitCacheWriter::finish() {
+  if (file == nullptr) return false;
+  bool isOK = fseek(file, 24, SEEK_SET) == 0 && fwrite(&numEvents, sizeof(numEvents), 1, file) == 1;
+  isOK = fclose(file) == 0 && isOK;
+  file = nullptr;
+  if (isOK) isOK = rename(tmpFilename.c_str(), filename.c_str()) == 0;
+  if (!isOK) remove(tmpFilename.c_str());
+  return isOK;
+}
+
+Analysis::HitCacheReader::HitCacheReader(const std::string filename)
+    : fd(-1), pBegin(nullptr), size(0), pNext(nullptr), maxHits(0), lmfSize(0), lmfMtime(0),
+      numEvents(0), eventNumber(0) {
+  const int f = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (f < 0) return;
+  struct stat st;
+  if (fstat(f, &st) != 0 || st.st_size < HIT_CACHE_HEADER_SIZE) {
+    close(f);
+    return;
+  }
+  size = (size_t) st.st_size;
+  void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, f, 0);
+  if (p == MAP_FAILED) {
+    close(f);
+    size = 0;
+    return;
+  }
+  madvise(p, size, MADV_SEQUENTIAL);
+  fd = f;
+  pBegin = (const char *) p;
+  uint32_t numChs, hits;
+  memcpy(&lmfSize, pBegin + 8, sizeof(lmfSize));
+  memcpy(&lmfMtime, pBegin + 16, sizeof(lmfMtime));
+  memcpy(&numEvents, pBegin + 24, sizeof(numEvents));
+  memcpy(&numChs, pBegin + 32, sizeof(numChs));
+  memcpy(&hits, pBegin + 36, sizeof(hits));
+  maxHits = (int) hits;
+  const size_t headerSize = padded(HIT_CACHE_HEADER_SIZE + 4 * (size_t) numChs);
+  if (memcmp(pBegin, HIT_CACHE_MAGIC, 8) != 0 || headerSize > size) {
+    munmap(p, size);
+    close(fd);
+    fd = -1;
+    return;
+  }
+  for (uint32_t k = 0; k < numChs; k++) {
+    uint32_t ch;
+    memcpy(&ch, pBegin + HIT_CACHE_HEADER_SIZE + 4 * k, sizeof(ch));
+    chs.push_back((int) ch);
+  }
+  pNext = pBegin + headerSize;
+}
+Analysis::HitCacheReader::~HitCacheReader() {
+  if (fd < 0) return;
+  munmap((void *) pBegin, size);
+  close(fd);
+}
+bool Analysis::HitCacheReader::isOpen() const { return fd >= 0; }
+bool Analysis::HitCacheReader::isMatching(const uint64_t size, const int64_t mtime,
+                                          const std::vector<int> &requiredChs) const {
+  if (!isOpen() || size != lmfSize || mtime != lmfMtime) return false;
+  for (const int ch : requiredChs) {
+    if (std::find(chs.begin(), chs.end(), ch) == chs.end()) return false;
+  }
+  return true;
+}
+bool Analysis::HitCacheReader::next(double &timestamp, unsigned int *count, int *tdc, const int rowLength) {
+  if (eventNumber >= numEvents) return false;
+  const char *p = pNext;
+  const char *pEnd = pBegin + size;
+  const size_t nCounts = countBytes(chs.size());
+  if (p + 8 + nCounts > pEnd) return false;
+  const auto *pCount = (const uint16_t *) (p + 8);
+  const auto *pHit = (const int32_t *) (p + 8 + nCounts);
+  size_t numHits = 0;
+  for (size_t k = 0; k < chs.size(); k++) numHits += pCount[k];
+  if ((const char *) (pHit + numHits) > pEnd) return false;
+  memcpy(&timestamp, p, sizeof(timestamp));
+  for (size_t k = 0; k < chs.size(); k++) {
+    const int ch = chs[k];
+    const int n = std::min<int>(pCount[k], rowLength);
+    count[ch] = (unsigned int) n;
+    memcpy(tdc + ch * rowLength, pHit, n * sizeof(int32_t));
+    pHit += pCount[k];
+  }
+  pNext = p + padded(8 + nCounts + numHits * sizeof(int32_t));
+  eventNumber++;
+  return true;
+}
+bool Analysis::HitCacheReader::skip() {
+  if (eventNumber >= numEvents) return false;
+  const size_t nCounts = countBytes(chs.size());
+  if (pNext + 8 + nCounts > pBegin + size) return false;
+  const auto *pCount = (const uint16_t *) (pNext + 8);
+  size_t numHits = 0;
+  for (size_t k = 0; k < chs.size(); k++) numHits += pCount[k];
+  pNext += padded(8 + nCounts + numHits * sizeof(int32_t));
+  eventNumber++;
+  return true;
+}
+uint64_t Analysis::HitCacheReader::getEventNumber() const { return eventNumber; }
+uint64_t Analysis::HitCacheReader::getNumberOfEvents() const { return numEvents; }
+uint64_t Analysis::HitCacheReader::getPosition() const { return (uint64_t) (pNext - pBegin); }
@@ -0,0 +1,62 @@
+#ifndef ANALYSIS_HITCACHE_H
+#define ANALYSIS_HITCACHE_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+// Decoded hits of an LMF file, only the channels the sorters read. A re-sort with new
+// factors reads them from the mapped file instead of decoding the LMF file again.
+//   header:  "SP8HITS1", LMF size (u64), LMF mtime (i64, ns), number of events (u64),
+//            number of channels (u32), max hits (u32), the channels (u32 each), padded to 8 bytes
+//   events:  timestamp (double), hit counts (u16 per channel), the hits (i32), padded to 8 bytes
+#define HIT_CACHE_MAGIC "SP8HITS1"
+#define HIT_CACHE_HEADER_SIZE 40
+
+namespace Analysis {
+class HitCacheWriter {
+  std::string filename, tmpFilename;
+  FILE *file;
+  std::vector<int> chs;
+  int maxHits;
+  uint64_t numEvents;
+  std::vector<char> record;
+ public:
+  // written to filename.tmp and renamed by finish
+  HitCacheWriter(const std::string filename, const std::vector<int> chs, const int maxHits,
+                 const uint64_t lmfSize, const int64_t lmfMtime);
+  ~HitCacheWriter(); // removes the unfinished file
+  bool isOpen() const;
+  // tdc: rowLength slots per channel like LMFWrapper::pTDC
+  void write(const double timestamp, const unsigned int *count, const int *tdc, const int rowLength);
+  bool finish();
+};
+
+class HitCacheReader {
+  int fd;
+  const char *pBegin;
+  size_t size;
+  const char *pNext;
+  std::vector<int> chs;
+  int maxHits;
+  uint64_t lmfSize;
+  int64_t lmfMtime;
+  uint64_t numEvents, eventNumber;
+ public:
+  HitCacheReader(const std::string filename);
+  ~HitCacheReader();
+  bool isOpen() const;
+  // the cache is of this LMF file and has all the channels
+  bool isMatching(const uint64_t size, const int64_t mtime, const std::vector<int> &requiredChs) const;
+  // count and tdc are not cleared, only the cached channels are written
+  bool next(double &timestamp, unsigned int *count, int *tdc, const int rowLength);
+  bool skip();
+  uint64_t getEventNumber() const;
+  uint64_t getNumberOfEvents() const;
+  uint64_t getPosition() const; // [bytes]
+};
+}
+
+#endif //ANALYSIS_HITCACHE_H
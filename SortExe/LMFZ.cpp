@@ -0,0 +1,209 @@
+#include "LMFZ.h"
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+Analysis::LMFZReader::LMFZReader(const std::string filename, int numThreads)
+    : fd(-1), blockSize(0), size(0), numReadAhead(0), currentIndex(0), isStopping(false) {
+  const int f = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (f < 0) return;
+  char header[LMFZ_HEADER_SIZE];
+  uint64_t numBlocks = 0, indexPosition = 0;
+  bool isOK = pread(f, header, sizeof(header), 0) == (ssize_t) sizeof(header)
+      && memcmp(header, LMFZ_MAGIC, 8) == 0;
+  if (isOK) {
+    memcpy(&blockSize, header + 8, sizeof(blockSize));
+    memcpy(&size, header + 16, sizeof(size));
+    memcpy(&numBlocks, header + 24, sizeof(numBlocks));
+    memcpy(&indexPosition, header + 32, sizeof(indexPosition));
+    isOK = blockSize > 0 && numBlocks == (size + blockSize - 1) / blockSize;
+  }
+  if (isOK) {
+    std::vector<uint64_t> index(2 * numBlocks);
+    const auto indexSize = (ssize_t) (index.size() * sizeof(uint64_t));
+    isOK = pread(f, index.data(), (size_t) indexSize, (off_t) indexPosition) == indexSize;
+    for (uint64_t i = 0; isOK && i < numBlocks; i++) {
+      positions.push_back(index[2 * i]);
+      packedSizes.push_back(index[2 * i + 1]);
+    }
+  }
+  if (!isOK) {
+    close(f);
+    size = 0;
+    return;
+  }
+  fd = f;
+  if (numThreads <= 0) numThreads = (int) std::min(4u, std::max(1u, std::thread::hardware_concurrency()));
+  numReadAhead = 2 * numThreads;
+  for (int i = 0; i < numThreads; i++) workers.emplace_back(&LMFZReader::runWorker, this);
+}
+Analysis::LMFZReader::~LMFZReader() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    isStopping = true;
+  }
+  cvRequested.notify_all();
+  for (auto &worker : workers) worker.join();
+  if (fd >= 0) close(fd);
+}
+bool Analysis::LMFZReader::isOpen() const { return fd >= 0; }
+uint64_t Analysis::LMFZReader::getSize() const { return size; }
+bool Analysis::LMFZReader::unpackBlock(const uint64_t i, std::vector<char> &data) const {
+  std::vector<char> packed(packedSizes[i]);
+  if (pread(fd, packed.data(), packed.size(), (off_t) positions[i]) != (ssize_t) packed.size()) return false;
+  const uint64_t expected = std::min<uint64_t>(blockSize, size - i * blockSize);
+  data.resize(expected);
+  uLongf len = (uLongf) expected;
+  const int result = uncompress((Bytef *) data.data(), &len, (const Bytef *) packed.data(), (uLong) packed.size());
+  return result == Z_OK && len == expected;
+}
+void Analysis::LMFZReader::runWorker() {
+  while (true) {
+    std::pair<uint64_t, std::shared_ptr<Block>> request;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cvRequested.wait(lock, [this] { return isStopping || !requests.empty(); });
+      if (isStopping) return;
+      request = requests.front();
+      requests.pop_front();
+    }
+    std::vector<char> data;
+    const bool isOK = unpackBlock(request.first, data);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      request.second->data.swap(data);
+      request.second->isFailed = !isOK;
+      request.second->isReady = true;
+    }
+    cvDone.notify_all();
+  }
+}
+std::shared_ptr<Analysis::LMFZReader::Block> Analysis::LMFZReader::getBlock(const uint64_t i) {
+  if (pCurrent && currentIndex == i) return pCurrent;
+  std::unique_lock<std::mutex> lock(mutex);
+  // the window moves with the reader, after a seek the blocks of the old window are dropped
+  const uint64_t last = std::min<uint64_t>(i + numReadAhead, positions.size() - 1);
+  const auto isOutside = [i, last](const uint64_t k) { return k < i || k > last; };
+  for (auto it = blocks.begin(); it != blocks.end();) {
+    if (isOutside(it->first)) it = blocks.erase(it);
+    else ++it;
+  }
+  requests.erase(std::remove_if(requests.begin(), requests.end(),
+                                [&isOutside](const std::pair<uint64_t, std::shared_ptr<Block>> &r) {
+                                  return isOutside(r.first);
+                                }), requests.end());
+  for (uint64_t k = i; k <= last; k++) {
+    if (blocks.count(k)) continue;
+    const auto p = std::make_shared<Block>();
+    blocks[k] = p;
+    requests.emplace_back(k, p);
+  }
+  cvRequested.notify_all();
+  const auto p = blocks[i];
+  cvDone.wait(lock, [&p] { return p->isReady; });
+  if (p->isFailed) return nullptr;
+  pCurrent = p;
+  currentIndex = i;
+  return p;
+}
+size_t Analysis::LMFZReader::read(char *dest, size_t n, uint64_t pos) {
+  size_t done = 0;
+  while (done < n && pos < size) {
+    const uint64_t i = pos / blockSize;
+    const auto p = getBlock(i);
+    if (!p) break;
+    const size_t offset = (size_t) (pos - i * blockSize);
+    const size_t len = std::min(n - done, p->data.size() - offset);
+    memcpy(dest + done, p->data.data() + offset, len);
+    done += len;
+    pos += len;
+  }
+  return done;
+}
+bool Analysis::LMFZReader::isPacked(const std::string filename) {
+  std::ifstream file(filename, std::ios::binary);
+  char magic[8];
+  if (!file.read(magic, sizeof(magic))) return false;
+  return memcmp(magic, LMFZ_MAGIC, sizeof(magic)) == 0;
+}
+
+bool Analysis::packLMF(const std::string lmfFilename, const std::string packedFilename,
+                       const uint32_t blockSize, const int level, int numThreads) {
+  if (blockSize == 0 || level < 0 || level > 9) return false;
+  std::ifstream in(lmfFilename, std::ios::binary);
+  if (!in) return false;
+  std::ofstream out(packedFilename, std::ios::binary | std::ios::trunc);
+  if (!out) return false;
+  if (numThreads <= 0) numThreads = (int) std::max(1u, std::thread::hardware_concurrency());
+  char header[LMFZ_HEADER_SIZE] = {};
+  out.write(header, sizeof(header)); // written again at the end
+
+  uint64_t size = 0, position = LMFZ_HEADER_SIZE;
+  std::vector<uint64_t> index;
+  std::vector<std::vector<char>> raws(numThreads), packs(numThreads);
+  std::vector<int> results(numThreads);
+  bool isEnd = false;
+  while (!isEnd) {
+    // a batch of blocks is compressed in parallel and written in order
+    int n = 0;
+    while (n < numThreads && !isEnd) {
+      raws[n].resize(blockSize);
+      in.read(raws[n].data(), blockSize);
+      raws[n].resize((size_t) in.gcount());
+      isEnd = raws[n].size() < blockSize;
+      if (raws[n].empty()) break;
+      size += raws[n].size();
+      n++;
+    }
+    if (in.bad()) return false;
+    std::vector<std::thread> threads;
+    for (int k = 0; k < n; k++) {
+      threads.emplace_back([&, k]() {
+        uLongf len = compressBound((uLong) raws[k].size());
+        packs[k].resize(len);
+        results[k] = compress2((Bytef *) packs[k].data(), &len,
+                               (const Bytef *) raws[k].data(), (uLong) raws[k].size(), level);
+        packs[k].resize(len);
+      });
+    }
+    for (auto &thread : threads) thread.join();
+    for (int k = 0; k < n; k++) {
+      if (results[k] != Z_OK) return false;
+      out.write(packs[k].data(), packs[k].size());
+      index.push_back(position);
+      index.push_back(packs[k].size());
+      position += packs[k].size();
+    }
+  }
+  out.write((const char *) index.data(), index.size() * sizeof(uint64_t));
+
+  const uint32_t lev = (uint32_t) level;
+  const uint64_t numBlocks = index.size() / 2;
+  memcpy(header, LMFZ_MAGIC, 8);
+  memcpy(header + 8, &blockSize, sizeof(blockSize));
+  memcpy(header + 12, &lev, sizeof(lev));
+  memcpy(header + 16, &size, sizeof(size));
+  memcpy(header + 24, &numBlocks, sizeof(numBlocks));
+  memcpy(header + 32, &position, sizeof(position));
+  out.seekp(0);
+  out.write(header, sizeof(header));
+  return (bool) out;
+}
+bool Analysis::unpackLMF(const std::string packedFilename, const std::string lmfFilename) {
+  LMFZReader reader(packedFilename);
+  if (!reader.isOpen()) return false;
+  std::ofstream out(lmfFilename, std::ios::binary | std::ios::trunc);
+  if (!out) return false;
+  std::vector<char> buffer(4 * 1024 * 1024);
+  uint64_t pos = 0;
+  while (pos < reader.getSize()) {
+    const size_t n = reader.read(buffer.data(), buffer.size(), pos);
+    if (n == 0) return false;
+    out.write(buffer.data(), n);
+    pos += n;
+  }
+  return (bool) out;
+}
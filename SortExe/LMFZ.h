@@ -0,0 +1,66 @@
+#ifndef ANALYSIS_LMFZ_H
+#define ANALYSIS_LMFZ_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
+
+// Block-compressed LMF files: the LMF file is cut into blocks of the same size which
+// are compressed one by one with zlib, and an index of the blocks is appended, so any
+// byte of the LMF file is found without reading the blocks before it.
+//   header: "SP8LMFZ1", block size (u32), zlib level (u32), LMF size (u64),
+//           number of blocks (u64), index position (u64)
+//   blocks: zlib streams, the last one may be shorter
+//   index:  position (u64) and compressed size (u64) of each block
+#define LMFZ_MAGIC "SP8LMFZ1"
+#define LMFZ_HEADER_SIZE 40
+
+namespace Analysis {
+// Reads the LMF bytes of a packed file, MyFILE of LMF_IO uses it for the packed input files.
+// The blocks after the one being read are decompressed ahead by worker threads.
+class LMFZReader {
+  struct Block {
+    bool isReady = false;
+    bool isFailed = false;
+    std::vector<char> data;
+  };
+  int fd;
+  uint32_t blockSize;
+  uint64_t size;
+  std::vector<uint64_t> positions, packedSizes;
+  int numReadAhead;
+  std::map<uint64_t, std::shared_ptr<Block>> blocks; // requested blocks by index
+  std::deque<std::pair<uint64_t, std::shared_ptr<Block>>> requests;
+  std::shared_ptr<Block> pCurrent;
+  uint64_t currentIndex;
+  std::mutex mutex;
+  std::condition_variable cvRequested, cvDone;
+  bool isStopping;
+  std::vector<std::thread> workers;
+  void runWorker();
+  bool unpackBlock(const uint64_t i, std::vector<char> &data) const;
+  std::shared_ptr<Block> getBlock(const uint64_t i);
+ public:
+  // numThreads=0: the number of cores, at most 4
+  LMFZReader(const std::string filename, int numThreads = 0);
+  ~LMFZReader();
+  bool isOpen() const;
+  uint64_t getSize() const; // of the LMF file
+  // copies the LMF bytes at pos, returns the number of bytes copied
+  size_t read(char *dest, size_t n, uint64_t pos);
+  static bool isPacked(const std::string filename);
+};
+
+// lossless conversion between LMF and packed files
+bool packLMF(const std::string lmfFilename, const std::string packedFilename,
+             const uint32_t blockSize, const int level, int numThreads);
+bool unpackLMF(const std::string packedFilename, const std::string lmfFilename);
+}
+
+#endif //ANALYSIS_LMFZ_H
@@ -1,4 +1,7 @@
 #include "LMF_IO.h"
+#include "LMFZ.h"
+#include <algorithm>
+#include <sys/stat.h>
 
 #ifndef LINUX
 	#define WINVER 0x0501
@@ -16,6 +19,7 @@
 
 void MyFILE::seek(unsigned __int64 pos)
 {
+	if (packed) {position = pos; return;}
 	__int32 rval = _fseeki64(file,  pos,SEEK_SET);
 	if (rval == 0) this->position = pos; else error = 1;
 
@@ -56,6 +60,46 @@ void MyFILE::seek_to_end()
 
 
 
+bool MyFILE::is_packed(__int8* name)
+{
+	return Analysis::LMFZReader::isPacked(name);
+}
+
+
+
+bool MyFILE::open_packed(__int8* name)
+{
+	packed = new Analysis::LMFZReader(name);
+	if (!packed->isOpen()) {delete packed; packed = 0; error = 1; return false;}
+	filesize = packed->getSize();	// the size of the LMF file, the positions are in the LMF file
+	position = 0;
+	return true;
+}
+
+
+
+void MyFILE::close_packed()
+{
+	delete packed;
+	packed = 0;
+}
+
+
+
+void MyFILE::read_packed(__int8* dest,__int32 length_bytes)
+{
+	size_t read_bytes = packed->read(dest, (size_t)length_bytes, position);
+	if (read_bytes != (size_t)length_bytes) {
+		error = 1;
+		eof = true;
+	}
+	position += length_bytes;
+}
+
+
+
+
+
 #define INT_MIN_ (-2147483647-1)
 
 
@@ -396,6 +440,9 @@ void LMF_IO::Initialize()
 	number_of_hits = new unsigned __int32[num_channels];
 
 	memset(number_of_hits,0,num_channels*sizeof(__int32));
+	memset(i32TDC,0,num_channels*num_ions*4);
+	memset(us16TDC,0,num_channels*num_ions*2);
+	memset(dTDC,0,num_channels*num_ions*8);
 
 	TDC8HP.DMAEnable = true;
 	TDC8HP.SSEEnable = false;
@@ -432,6 +479,9 @@ void LMF_IO::Initialize()
 
 	LMF_Header_version = 476759;
 	ui64LevelInfo = 0;
+	TDC8HP_word_table_channels = -1;
+	TDC8HP_word_table_offset = 0;
+	checkpoint_interval = 10000;
 
 	Cobold_Header_version = 2002;
 	Cobold_Header_version_output = 0;
@@ -522,12 +572,13 @@ void LMF_IO::Initialize()
 	error_text[13] = (char*)"could not connect CAchrive to output file";
 	error_text[14] = (char*)"some parameters are not initialized";
 	error_text[15] = (char*)"CAMAC data tried to read with wrong function";
-	error_text[16] = (char*)"seek does not work with non-fixed event lengths";
+	error_text[16] = (char*)"seek does not work with non-fixed event lengths without checkpoints";
 	error_text[17] = (char*)"writing file with non-fixed event length dan DAQVersion < 2008 no possible";
 	error_text[18] = (char*)"end of input file";
 	error_text[19] = (char*)"more channels in file than specified at new LMF_IO()";
 	error_text[20] = (char*)"more hits per channel in file than specified at new LMF_IO()";
 	error_text[21] = (char*)"more bytes after event than are reserved in LMF_IO source code";
+	error_text[22] = (char*)"checkpoint file does not belong to the input file";
 }
 
 
@@ -638,6 +689,7 @@ bool LMF_IO::OpenInputLMF(__int8 * LMF_Filename)
 		input_lmf = 0;
 		return false;
 	}
+	input_lmf_filename = LMF_Filename;
 
 //L10:
 
@@ -868,6 +920,10 @@ L100:
 
 L666:
 
+	uint64_number_of_read_events = 0;
+	checkpoints.clear();
+	AddCheckpoint();
+
 	return true;
 }
 
@@ -4871,32 +4927,41 @@ bool LMF_IO::SeekToEventNumber(unsigned __int64 target_number)
 {
 	if (DAQ_ID == DAQ_ID_SIMPLE) return false;
 
-	if (target_number == 0) {
-		input_lmf->seek((unsigned __int64)(Headersize + User_header_size));
-		must_read_first = true;
-		errorflag = 0;
-		input_lmf->error = 0;
-		return true;
-	}
-
-	if (data_format_in_userheader == LM_USERDEF) {errorflag = 16; return false;}
-
 	if (!input_lmf) {
 		errorflag = 9;
 		return false;
 	}
 
+	bool fixed_event_length = (data_format_in_userheader == 2 || data_format_in_userheader == 5 || data_format_in_userheader == 10 || DAQ_ID == DAQ_ID_RAW32BIT);
+	if (TDC8HP.variable_event_length == 1 || TDC8PCI2.variable_event_length == 1) fixed_event_length = false;
+	if (DAQ_ID == DAQ_ID_RAW32BIT) fixed_event_length = true;
 
-/*	unsigned __int64 filesize;
-	unsigned __int64 pos = input_lmf->tell();
-	input_lmf->seek_to_end();
-	filesize = input_lmf->tell();
-	input_lmf->seek(pos);
-*/
+	if (!fixed_event_length) {
+		if (checkpoints.empty()) {errorflag = 16; return false;}
+		if (uint64_Numberofevents && target_number > uint64_Numberofevents) return false;
+		unsigned __int64 k = checkpoint_interval ? target_number / checkpoint_interval : 0;
+		if (k >= checkpoints.size()) k = checkpoints.size() - 1;
+		// reading on is faster if the current event is between the checkpoint and the target
+		bool read_on = !must_read_first && !errorflag && !input_lmf->error;
+		if (uint64_number_of_read_events < k * checkpoint_interval || uint64_number_of_read_events > target_number) read_on = false;
+		if (!read_on) RestoreCheckpoint(k);
+		while (uint64_number_of_read_events < target_number) {
+			if (!ReadNextEvent()) return false;	// the checkpoints after k are taken on the way
+		}
+		must_read_first = true;
+		errorflag = 0;
+		return true;
+	}
 
-	
+	if (target_number == 0) {
+		input_lmf->seek((unsigned __int64)(Headersize + User_header_size));
+		uint64_number_of_read_events = 0;
+		must_read_first = true;
+		errorflag = 0;
+		input_lmf->error = 0;
+		return true;
+	}
 
-	if (target_number < 0) return false;
 	if (target_number > uint64_Numberofevents) return false;
 	__int32 eventsize;
 	if (data_format_in_userheader == 2 ) eventsize = 2 * Numberofcoordinates;
@@ -4926,12 +4991,339 @@ bool LMF_IO::SeekToEventNumber(unsigned __int64 target_number)
 
 
 
+/////////////////////////////////////////////////////////////////
+void LMF_IO::AddCheckpoint()
+/////////////////////////////////////////////////////////////////
+{
+	LMF_checkpoint checkpoint;
+	unsigned __int64 number;
+	GetReaderState(checkpoint, number);
+	checkpoints.push_back(checkpoint);
+}
+
+
+
+
+
+
+
+/////////////////////////////////////////////////////////////////
+void LMF_IO::GetReaderState(LMF_checkpoint &state, unsigned __int64 &number_of_read_events)
+/////////////////////////////////////////////////////////////////
+{
+	state.position = input_lmf->tell();
+	state.ui64LevelInfo = ui64LevelInfo;
+	state.ui64RollOvers = TDC8HP.ui64RollOvers;
+	state.ui64TDC8HP_AbsoluteTimeStamp = TDC8HP.ui64TDC8HP_AbsoluteTimeStamp;
+	state.ui32oldRollOver = TDC8HP.ui32oldRollOver;
+	state.ui32AbsoluteTimeStamp = TDC8HP.ui32AbsoluteTimeStamp;
+	for (__int32 i=0;i<32;i++) state.Parameter_901_932[i] = Parameter ? Parameter[901+i] : 0.;
+	number_of_read_events = uint64_number_of_read_events;
+}
+
+
+
+
+
+
+
+/////////////////////////////////////////////////////////////////
+void LMF_IO::SetReaderState(const LMF_checkpoint &state, unsigned __int64 number_of_read_events)
+/////////////////////////////////////////////////////////////////
+{
+	input_lmf->clear_error();
+	input_lmf->seek(state.position);
+	ui64LevelInfo = state.ui64LevelInfo;
+	TDC8HP.ui64RollOvers = state.ui64RollOvers;
+	TDC8HP.ui64TDC8HP_AbsoluteTimeStamp = state.ui64TDC8HP_AbsoluteTimeStamp;
+	TDC8HP.ui32oldRollOver = state.ui32oldRollOver;
+	TDC8HP.ui32AbsoluteTimeStamp = state.ui32AbsoluteTimeStamp;
+	if (Parameter) for (__int32 i=0;i<32;i++) Parameter[901+i] = state.Parameter_901_932[i];
+	uint64_number_of_read_events = number_of_read_events;
+	must_read_first = true;
+	errorflag = 0;
+}
+
+
+
+
+
+
+
+/////////////////////////////////////////////////////////////////
+void LMF_IO::RestoreCheckpoint(unsigned __int64 k)
+/////////////////////////////////////////////////////////////////
+{
+	SetReaderState(checkpoints[k], k * checkpoint_interval);
+}
+
+
+
+
+
+
+
+/////////////////////////////////////////////////////////////////
+void LMF_IO::SetCheckpointInterval(unsigned __int32 interval)
+/////////////////////////////////////////////////////////////////
+{
+	if (interval == checkpoint_interval) return;
+	checkpoint_interval = interval;
+	if (checkpoints.size() > 1) checkpoints.resize(1);	// the first event is the same for all intervals
+}
+
+
+
+
+
+
+
+/////////////////////////////////////////////////////////////////
+unsigned __int32 LMF_IO::GetCheckpointInterval()
+/////////////////////////////////////////////////////////////////
+{
+	return checkpoint_interval;
+}
+
+
+
+
+
+
+
+/////////////////////////////////////////////////////////////////
+unsigned __int64 LMF_IO::GetNumberOfCheckpoints()
+/////////////////////////////////////////////////////////////////
+{
+	return checkpoints.size();
+}
+
+
+
+
+
+
+
+/////////////////////////////////////////////////////////////////
+bool LMF_IO::GetInputFileStamp(unsigned __int64 &size, __int64 &mtime_ns)
+/////////////////////////////////////////////////////////////////
+{
+	struct stat st;
+	if (input_lmf_filename.empty() || stat(input_lmf_filename.c_str(), &st) != 0) return false;
+	size = (unsigned __int64)st.st_size;
+#ifdef LINUX
+	mtime_ns = (__int64)st.st_mtim.tv_sec * 1000000000 + (__int64)st.st_mtim.tv_nsec;
+#else
+	mtime_ns = (__int64)st.st_mtime * 1000000000;
+#endif
+	return true;
+}
+
+
+
+
+
+
+
+/////////////////////////////////////////////////////////////////
+bool LMF_IO::SaveCheckpoints(std::string Filename)
+/////////////////////////////////////////////////////////////////
+{
+	// "LMFCKPT2", size and mtime [ns] of the LMF file, interval, number of checkpoints, the checkpoints
+	unsigned __int64 lmf_size;
+	__int64 lmf_mtime;
+	if (!GetInputFileStamp(lmf_size, lmf_mtime)) return false;
+	std::ofstream file(Filename.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file) return false;
+	unsigned __int64 number = checkpoints.size();
+	file.write("LMFCKPT2", 8);
+	file.write((const char*)&lmf_size, sizeof(lmf_size));
+	file.write((const char*)&lmf_mtime, sizeof(lmf_mtime));
+	file.write((const char*)&checkpoint_interval, sizeof(checkpoint_interval));
+	file.write((const char*)&number, sizeof(number));
+	if (number) file.write((const char*)&checkpoints[0], number * sizeof(LMF_checkpoint));
+	return file.good();
+}
+
+
+
+
+
+
+
+/////////////////////////////////////////////////////////////////
+bool LMF_IO::LoadCheckpoints(std::string Filename)
+/////////////////////////////////////////////////////////////////
+{
+	if (!input_lmf || checkpoints.empty()) {errorflag = 9; return false;}
+	std::ifstream file(Filename.c_str(), std::ios::binary);
+	if (!file) return false;
+	char magic[8];
+	unsigned __int64 saved_size = 0, lmf_size;
+	__int64 saved_mtime = 0, lmf_mtime;
+	unsigned __int32 interval = 0;
+	unsigned __int64 number = 0;
+	file.read(magic, 8);
+	file.read((char*)&saved_size, sizeof(saved_size));
+	file.read((char*)&saved_mtime, sizeof(saved_mtime));
+	file.read((char*)&interval, sizeof(interval));
+	file.read((char*)&number, sizeof(number));
+	if (!file || memcmp(magic, "LMFCKPT2", 8) != 0 || !interval || !number) {errorflag = 22; return false;}
+	// a table of an older version of the LMF file is stale, also if its first checkpoints still fit
+	if (!GetInputFileStamp(lmf_size, lmf_mtime) || lmf_size != saved_size || lmf_mtime != saved_mtime) {errorflag = 22; return false;}
+	std::vector<LMF_checkpoint> loaded((size_t)number);
+	file.read((char*)&loaded[0], number * sizeof(LMF_checkpoint));
+	if (!file) {errorflag = 22; return false;}
+	// the first event follows the header, the last one has to be in the file
+	if (loaded[0].position != checkpoints[0].position || loaded.back().position > input_lmf->filesize) {errorflag = 22; return false;}
+	if (interval == checkpoint_interval && loaded.size() < checkpoints.size()) return true;	// the own table is longer
+	checkpoint_interval = interval;
+	checkpoints.swap(loaded);
+	return true;
+}
+
+
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////
+void LMF_IO::Build_TDC8HP_word_table()
+///////////////////////////////////////////////////////////////////////////////////
+{
+	// the class of a raw word and the channel of a hit only depend on its top byte
+	for (__int32 b = 0; b < 256; ++b) {
+		__int16 entry = TDC8HP_WORD_IGNORED;
+		if ((b & 0xf8) == 0x18) entry = TDC8HP_WORD_LEVELINFO;
+		else if ((b & 0xC0) > 0x40) {				// rising or falling trigger
+			unsigned __int8 ucTDCChannel = (unsigned __int8)(b & 0x3F);
+			// calculate TDC channel to _TDC channel
+			if((ucTDCChannel >= 42) && (ucTDCChannel <= 49))
+				ucTDCChannel -= 25;
+			else if((ucTDCChannel >= 21) && (ucTDCChannel <= 28))
+				ucTDCChannel -= 12;
+			if ((b & 0xC0) == 0xC0) ucTDCChannel += TDC8HP.channel_offset_for_rising_transitions;
+			if (ucTDCChannel < num_channels) entry = ucTDCChannel;
+		}
+		else if ((b & 0xf0) == 0x00) entry = TDC8HP_WORD_GROUP;
+		else if ((b & 0x10) == 0x10) entry = TDC8HP_WORD_ROLLOVER;
+		TDC8HP_word_table[b] = entry;
+	}
+	TDC8HP_word_table_offset = TDC8HP.channel_offset_for_rising_transitions;
+	TDC8HP_word_table_channels = num_channels;
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////
+void LMF_IO::Handle_TDC8HP_LevelInfo(unsigned __int32 ui32DataWord)
+///////////////////////////////////////////////////////////////////////////////////
+{
+	__int32 n = ui32DataWord & 0x7e00000;
+	n >>= 21;
+	unsigned __int64 ui64_temp_LevelInfo = ui32DataWord & 0x1fffff;
+	if (n > 20) return;
+	if (n < 9) ui64_temp_LevelInfo >>= (9-n); else ui64_temp_LevelInfo <<= (n-9);
+
+	n-=9;
+	if (n<0) n = 0;
+
+	unsigned __int64 ui64_tempL_LevelInfo = ui64LevelInfo >> (n+21);
+	ui64_tempL_LevelInfo <<= (n+21);
+	unsigned __int64 ui64_tempR_LevelInfo = n!=0 ? ui64LevelInfo << (64-n) : 0;
+	ui64_tempR_LevelInfo = n!=0 ? ui64_tempR_LevelInfo >> (64-n) : 0;
+
+	ui64LevelInfo = ui64_tempL_LevelInfo | ui64_tempR_LevelInfo | ui64_temp_LevelInfo;
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////
+void LMF_IO::Handle_TDC8HP_RollOver(unsigned __int32 ui32DataWord)
+///////////////////////////////////////////////////////////////////////////////////
+{
+	unsigned __int32 ui32newRollOver = (ui32DataWord & 0x00ffffff);
+	if (ui32newRollOver > this->TDC8HP.ui32oldRollOver) {
+		this->TDC8HP.ui64RollOvers += ui32newRollOver - this->TDC8HP.ui32oldRollOver;
+	} else if (ui32newRollOver < this->TDC8HP.ui32oldRollOver) {
+		this->TDC8HP.ui64RollOvers += ui32newRollOver;
+		this->TDC8HP.ui64RollOvers += 1;
+		this->TDC8HP.ui64RollOvers += (unsigned __int32)(0x00ffffff) - this->TDC8HP.ui32oldRollOver;
+	}
+	this->TDC8HP.ui32oldRollOver = ui32newRollOver;
+}
+
+
+
+
+
 ///////////////////////////////////////////////////////////////////////////////////
 __int32 LMF_IO::PCIGetTDC_TDC8HP_25psGroupMode(unsigned __int64 &ref_ui64TDC8HPAbsoluteTimeStamp, __int32 count, unsigned __int32 * Buffer)
 ///////////////////////////////////////////////////////////////////////////////////
 {
 	memset(number_of_hits,0,num_channels*sizeof(__int32));		// clear the hit-counts values in _TDC array
 
+	// the words are classified by a table, so a hit costs one lookup and no mask tests
+	if (TDC8HP_word_table_channels != num_channels
+		|| TDC8HP_word_table_offset != TDC8HP.channel_offset_for_rising_transitions) Build_TDC8HP_word_table();
+	const __int16 * table = TDC8HP_word_table;
+	const __int32 shift = this->TDC8HP.VHR_25ps ? 0 : 2;		// correct for 100ps if necessary
+	unsigned __int32 * hits = number_of_hits;
+	__int32 * tdc = i32TDC;
+	const unsigned __int32 max_hits = (unsigned __int32) num_ions;
+
+	bool bOKFlag = false;
+	for(__int32 i = 0; i < count ; ++i)
+	{
+		const unsigned __int32 ui32DataWord = Buffer[i];
+		const __int32 entry = table[ui32DataWord >> 24];
+		if (entry >= 0)								// a hit of the channel entry
+		{
+			const __int32 lTDCData = ((__int32)(ui32DataWord << 8)) >> (8 + shift);	// 24 bit signed
+			const unsigned __int32 cnt = hits[entry];
+			if (cnt < max_hits) {					// the oversized hits are dropped
+				tdc[entry*max_hits+cnt] = lTDCData;
+				hits[entry] = cnt + 1;
+			}
+			bOKFlag = true;
+			continue;
+		}
+		switch (entry) {
+			case TDC8HP_WORD_LEVELINFO: Handle_TDC8HP_LevelInfo(ui32DataWord); break;
+			case TDC8HP_WORD_GROUP: this->TDC8HP.ui32AbsoluteTimeStamp = ui32DataWord & 0x00ffffff; break;
+			case TDC8HP_WORD_ROLLOVER: Handle_TDC8HP_RollOver(ui32DataWord); break;
+			default: break;							// error words and channels out of range
+		}
+	}
+
+	if (bOKFlag)
+	{
+		ref_ui64TDC8HPAbsoluteTimeStamp  = this->TDC8HP.ui64RollOvers * (unsigned __int64)(0x0000000001000000);
+		ref_ui64TDC8HPAbsoluteTimeStamp += (unsigned __int64)(this->TDC8HP.ui32AbsoluteTimeStamp);
+		this->TDC8HP.ui64TDC8HP_AbsoluteTimeStamp = ref_ui64TDC8HPAbsoluteTimeStamp;
+	}
+	
+	return bOKFlag;
+}
+
+
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////
+__int32 LMF_IO::PCIGetTDC_TDC8HP_25psGroupMode_Reference(unsigned __int64 &ref_ui64TDC8HPAbsoluteTimeStamp, __int32 count, unsigned __int32 * Buffer)
+///////////////////////////////////////////////////////////////////////////////////
+{
+	// the decoder before the table, which tests every word; kept to check the table decoder
+	memset(number_of_hits,0,num_channels*sizeof(__int32));		// clear the hit-counts values in _TDC array
+
 	unsigned __int32 ui32DataWord;
 	bool bOKFlag = false;
 	unsigned __int8 ucTDCChannel;
@@ -5043,6 +5435,52 @@ __int32 LMF_IO::PCIGetTDC_TDC8HP_25psGroupMode(unsigned __int64 &ref_ui64TDC8HPA
 
 
 
+///////////////////////////////////////////////////////////////////////////////////
+bool LMF_IO::CompareTDC8HPGroupModeDecoders(__int32 count, unsigned __int32 * Buffer)
+///////////////////////////////////////////////////////////////////////////////////
+{
+	if (!number_of_hits || !i32TDC) return false;
+	const unsigned __int64 ui64LevelInfo_before = ui64LevelInfo;
+	const unsigned __int64 ui64RollOvers_before = TDC8HP.ui64RollOvers;
+	const unsigned __int32 ui32oldRollOver_before = TDC8HP.ui32oldRollOver;
+	const unsigned __int32 ui32AbsoluteTimeStamp_before = TDC8HP.ui32AbsoluteTimeStamp;
+	const unsigned __int64 ui64AbsoluteTimeStamp_before = TDC8HP.ui64TDC8HP_AbsoluteTimeStamp;
+
+	// the slots which are not written keep a pattern, so a stray write is found too
+	for (__int32 i=0;i<num_channels*num_ions;++i) i32TDC[i] = 0x5a5a5a5a;
+	unsigned __int64 ref_timestamp = 0xa5a5a5a5a5a5a5a5;
+	const __int32 ref_result = PCIGetTDC_TDC8HP_25psGroupMode_Reference(ref_timestamp, count, Buffer);
+	const std::vector<unsigned __int32> ref_hits(number_of_hits, number_of_hits + num_channels);
+	const std::vector<__int32> ref_tdc(i32TDC, i32TDC + num_channels*num_ions);
+	const unsigned __int64 ref_LevelInfo = ui64LevelInfo;
+	const unsigned __int64 ref_RollOvers = TDC8HP.ui64RollOvers;
+	const unsigned __int32 ref_oldRollOver = TDC8HP.ui32oldRollOver;
+	const unsigned __int32 ref_AbsoluteTimeStamp = TDC8HP.ui32AbsoluteTimeStamp;
+	const unsigned __int64 ref_AbsoluteTimeStamp64 = TDC8HP.ui64TDC8HP_AbsoluteTimeStamp;
+
+	ui64LevelInfo = ui64LevelInfo_before;
+	TDC8HP.ui64RollOvers = ui64RollOvers_before;
+	TDC8HP.ui32oldRollOver = ui32oldRollOver_before;
+	TDC8HP.ui32AbsoluteTimeStamp = ui32AbsoluteTimeStamp_before;
+	TDC8HP.ui64TDC8HP_AbsoluteTimeStamp = ui64AbsoluteTimeStamp_before;
+	for (__int32 i=0;i<num_channels*num_ions;++i) i32TDC[i] = 0x5a5a5a5a;
+	unsigned __int64 timestamp = 0xa5a5a5a5a5a5a5a5;
+	const __int32 result = PCIGetTDC_TDC8HP_25psGroupMode(timestamp, count, Buffer);
+
+	return result == ref_result && timestamp == ref_timestamp
+		&& std::equal(ref_hits.begin(), ref_hits.end(), number_of_hits)
+		&& std::equal(ref_tdc.begin(), ref_tdc.end(), i32TDC)
+		&& ui64LevelInfo == ref_LevelInfo
+		&& TDC8HP.ui64RollOvers == ref_RollOvers
+		&& TDC8HP.ui32oldRollOver == ref_oldRollOver
+		&& TDC8HP.ui32AbsoluteTimeStamp == ref_AbsoluteTimeStamp
+		&& TDC8HP.ui64TDC8HP_AbsoluteTimeStamp == ref_AbsoluteTimeStamp64;
+}
+
+
+
+
+
 
 
 /////////////////////////////////////////////////////////////////
@@ -5104,11 +5542,9 @@ bool LMF_IO::ReadNextEvent()
 		return false;
 	}
 
-	if (data_format_in_userheader ==  2) memset(us16TDC,0,num_channels*num_ions*2);
-	if (data_format_in_userheader ==  5) memset(dTDC,0,num_channels*num_ions*8);
-	if (data_format_in_userheader == 10) memset(i32TDC,0,num_channels*num_ions*4);
-	if (TDC8HP.variable_event_length == 1) memset(i32TDC,0,num_channels*num_ions*4);
-	if (TDC8PCI2.variable_event_length == 1) memset(us16TDC,0,num_channels*num_ions*2);
+	if (checkpoint_interval && uint64_number_of_read_events == checkpoints.size() * (unsigned __int64)checkpoint_interval) AddCheckpoint();
+
+	ClearUsedTDCSlots();
 
 	unsigned __int64 HPTDC_event_length = 0;
 	unsigned __int64 TDC8PCI2_event_length = 0;
@@ -5458,6 +5894,9 @@ bool LMF_IO::ReadNextEvent()
 		}
 	}
 
+	// the level info, the parameters and the post event data of a truncated event
+	if (input_lmf->error) {if (input_lmf->eof) this->errorflag = 18; else this->errorflag = 2; return false;}
+
 	must_read_first = false;
 	return true;
 }
@@ -5742,6 +6181,85 @@ void LMF_IO::GetTDCDataArray(unsigned __int16 *tdc)
 
 
 
+/////////////////////////////////////////////////////////////////
+template <typename T> static void clear_used_slots(T *tdc, const unsigned __int32 *hits, __int32 num_channels, __int32 num_ions)
+/////////////////////////////////////////////////////////////////
+{
+	for (__int32 i=0;i<num_channels;++i) {
+		__int32 n = (hits[i] < (unsigned __int32)(num_ions)) ? hits[i] : num_ions;
+		if (n > 0) memset(tdc+i*num_ions,0,n*sizeof(T));
+	}
+}
+
+
+
+/////////////////////////////////////////////////////////////////
+void LMF_IO::ClearUsedTDCSlots()
+/////////////////////////////////////////////////////////////////
+{
+	// The arrays are zero beyond the hits of the previous event, so only
+	// these hits have to be cleared instead of the whole array.
+	if (data_format_in_userheader ==  2) clear_used_slots(us16TDC,number_of_hits,num_channels,num_ions);
+	if (data_format_in_userheader ==  5) clear_used_slots(dTDC,number_of_hits,num_channels,num_ions);
+	if (data_format_in_userheader == 10 || TDC8HP.variable_event_length == 1) clear_used_slots(i32TDC,number_of_hits,num_channels,num_ions);
+	if (data_format_in_userheader !=  2 && TDC8PCI2.variable_event_length == 1) clear_used_slots(us16TDC,number_of_hits,num_channels,num_ions);
+}
+
+
+
+/////////////////////////////////////////////////////////////////
+const __int32 * LMF_IO::GetTDCDataPointer()
+/////////////////////////////////////////////////////////////////
+{
+	if (must_read_first) {
+		if (!ReadNextEvent()) return 0;
+	}
+
+	if (data_format_in_userheader == LM_USERDEF) {
+		if (DAQ_ID == DAQ_ID_TDC8HP || DAQ_ID == DAQ_ID_TDC8HPRAW) return i32TDC;
+	}
+	if (data_format_in_userheader == 10) return i32TDC;
+	return 0;
+}
+
+
+
+/////////////////////////////////////////////////////////////////
+void LMF_IO::GetTDCDataArraySparse(__int32 *tdc)
+/////////////////////////////////////////////////////////////////
+{
+	__int32 i,j;
+	__int32 ii;
+
+	if (must_read_first) {
+		if (!ReadNextEvent()) return;
+	}
+
+	for (i=0;i<num_channels;++i) {
+		__int32 hits = (number_of_hits[i] < (unsigned __int32)(num_ions)) ? number_of_hits[i] : num_ions;
+		__int32 * out = tdc+i*num_ions;
+		if (data_format_in_userheader == LM_USERDEF) {
+			if (DAQ_ID == DAQ_ID_TDC8HP || DAQ_ID == DAQ_ID_TDC8HPRAW) memcpy(out,i32TDC+i*num_ions,hits*sizeof(__int32));
+			if (DAQ_ID == DAQ_ID_TDC8 || DAQ_ID == DAQ_ID_2TDC8 || DAQ_ID == DAQ_ID_HM1) {
+				for (j=0;j<hits;++j) out[j] = us16TDC[i*num_ions+j];
+			}
+		}
+		if (data_format_in_userheader == 10) memcpy(out,i32TDC+i*num_ions,hits*sizeof(__int32));
+		if (data_format_in_userheader == 2) {
+			for (j=0;j<hits;++j) out[j] =__int32(us16TDC[i*num_ions+j]);
+		}
+		if (data_format_in_userheader == 5) {
+			for (j=0;j<hits;++j) {
+				if (dTDC[i*num_ions+j] >= 0.) ii =__int32(dTDC[i*num_ions+j]+1.e-19);
+				if (dTDC[i*num_ions+j] <  0.) ii =__int32(dTDC[i*num_ions+j]-1.e-19);
+				out[j] = ii;
+			}
+		}
+	}
+}
+
+
+
 /////////////////////////////////////////////////////////////////
 void LMF_IO::GetTDCDataArray(double *tdc)
 /////////////////////////////////////////////////////////////////
@@ -2,6 +2,7 @@
 #define _LMF_IO_
 
 #include "fstream"
+#include "vector"
 //#include "stdio.h"
 #include "time.h"
 
@@ -274,22 +275,26 @@ struct ndigo_static_info {
 
 #define MAX_NUMBER_OF_BYTES_IN_POSTEVENTDATA 4000
 
+namespace Analysis {class LMFZReader;}
+
 class MyFILE
 {
 public:
-	MyFILE(bool mode_reading_) {error = 0; eof = false; mode_reading = mode_reading_; file = 0; position = 0; filesize = 0;}
+	MyFILE(bool mode_reading_) {error = 0; eof = false; mode_reading = mode_reading_; file = 0; packed = 0; position = 0; filesize = 0;}
 	~MyFILE() {close(); error = 0; eof = false;}
 
 	FILE * file;
+	Analysis::LMFZReader * packed;	// block-compressed input file, the blocks are decompressed ahead by threads
 
 	__int64 get_position() {
-		if (!file) return 0;
+		if (!file && !packed) return 0;
 		return position;
 	}
 
 	bool open(__int8* name) {
-		if (file) {error = 1; return false;}
+		if (file || packed) {error = 1; return false;}
 		eof = false;
+		if (mode_reading && is_packed(name)) return open_packed(name);
 		if (mode_reading) {
 			file = fopen(name,"rb");
 			if (!file) {error = 1; return false;}
@@ -305,7 +310,8 @@ public:
 	}
 
 	void close() {
-		if (file) {fclose(file);  file = 0;} else error = 1;
+		if (packed) close_packed();
+		else if (file) {fclose(file);  file = 0;} else error = 1;
 		position = 0; filesize = 0; eof = false;
 	}
 
@@ -313,6 +319,7 @@ public:
 	void seek(unsigned __int64 pos);
 
 	void read(__int8* string,__int32 length_bytes) {
+		if (packed) {read_packed(string,length_bytes); return;}
 		unsigned __int32 read_bytes = (unsigned __int32)(fread(string,1,length_bytes,file));
 		if (__int32(read_bytes) != length_bytes) {
 			error = 1;
@@ -322,6 +329,7 @@ public:
 	}
 
 	void read(unsigned __int32 * dest,__int32 length_bytes) {
+		if (packed) {read_packed((__int8*)dest,length_bytes); return;}
 		unsigned __int32 read_bytes = (unsigned __int32)(fread(dest,1,length_bytes,file));
 		if (__int32(read_bytes) != length_bytes) {
 			error = 1;
@@ -338,6 +346,9 @@ public:
 
 	void flush() {fflush(file);}
 
+	// for files which are still being written: forget the EOF of a short read
+	void clear_error() {if (file) clearerr(file); error = 0; eof = false;}
+
 	MyFILE & operator>>(unsigned __int8 &c)		{read((__int8*)&c,sizeof(unsigned __int8));		return *this;}
 	MyFILE & operator>>(__int8 &c)				{read((__int8*)&c,sizeof(__int8));				return *this;}
 	MyFILE & operator>>(unsigned __int16 &l)	{read((__int8*)&l,sizeof(unsigned __int16));	return *this;}
@@ -367,6 +378,11 @@ public:
 private:
 	bool mode_reading;
 	unsigned __int64 position;
+
+	bool is_packed(__int8* name);
+	bool open_packed(__int8* name);
+	void close_packed();
+	void read_packed(__int8* dest,__int32 length_bytes);
 };
 
 
@@ -419,6 +435,12 @@ typedef union _myLARGE_INTEGER {
 #define LM_LASTKNOWNDATAFORMAT	LM_SDOUBLELONG
 #define LM_USERDEF				-1	// user will handle the reading 
 
+// classes of the raw words of the TDC8HP group mode, a hit is given by its channel >= 0
+#define TDC8HP_WORD_IGNORED		-1	// error words and hits out of the channels
+#define TDC8HP_WORD_LEVELINFO	-2
+#define TDC8HP_WORD_GROUP		-3
+#define TDC8HP_WORD_ROLLOVER	-4
+
 
 
 
@@ -673,6 +695,22 @@ struct HM1_struct
 
 
 
+struct LMF_checkpoint	// the reader state before an event, the events of the variable-length formats can not be counted by bytes
+{
+	unsigned __int64	position;						// of the first byte of the event
+	unsigned __int64	ui64LevelInfo;
+	unsigned __int64	ui64RollOvers;
+	unsigned __int64	ui64TDC8HP_AbsoluteTimeStamp;
+	unsigned __int32	ui32oldRollOver;
+	unsigned __int32	ui32AbsoluteTimeStamp;
+	double				Parameter_901_932[32];		// only the changed parameters are in the events
+};
+
+
+
+
+
+
 
 
 
@@ -726,6 +764,8 @@ public:
 	void			GetTDCDataArray(__int32 *tdc);
 	void			GetTDCDataArray(double *tdc);
 	void			GetTDCDataArray(unsigned __int16 * tdc);
+	void			GetTDCDataArraySparse(__int32 *tdc);	// copies only the first number_of_hits[i] hits of channel i
+	const __int32 *	GetTDCDataPointer();	// view of the internal TDC array, 0 if the data is not stored as __int32
 
 	void			GetCAMACArray(unsigned __int32 []);
 	void			WriteCAMACArray(double, unsigned int[]);
@@ -737,6 +777,20 @@ public:
 	unsigned __int32	GetMaxNumberOfHits(); 
 	bool			SeekToEventNumber(unsigned __int64 Eventnumber);
 
+	// checkpoints of the variable-length formats, taken while reading every checkpoint_interval events.
+	// SeekToEventNumber starts at the last checkpoint before the event and reads the rest.
+	void			SetCheckpointInterval(unsigned __int32 interval);
+	unsigned __int32	GetCheckpointInterval();
+	unsigned __int64	GetNumberOfCheckpoints();
+	bool			SaveCheckpoints(std::string Filename);
+	bool			LoadCheckpoints(std::string Filename);	// replaces the table if it was saved for the input file of this size and mtime
+	// the reader state before the next event and its number, to read an incomplete event again
+	void			GetReaderState(LMF_checkpoint &state, unsigned __int64 &number_of_read_events);
+	void			SetReaderState(const LMF_checkpoint &state, unsigned __int64 number_of_read_events);
+	// decodes a group of raw TDC8HP words with the table and with the reference which tests each word,
+	// true if the hits, the level info, the rollovers and the time stamps are the same
+	bool			CompareTDC8HPGroupModeDecoders(__int32 count, unsigned __int32 * Buffer);
+
 	const char *	GetErrorText(__int32 error_id);
 	void			GetErrorText(__int32 error_id, __int8 char_buffer[]);
 	void			GetErrorText(__int8 char_buffer[]);
@@ -785,6 +839,7 @@ public:
 
 private:
 	void			Initialize();
+	void			ClearUsedTDCSlots();
 
 	void			write_times(MyFILE *,time_t,time_t);
 
@@ -816,6 +871,19 @@ private:
 	__int32			WriteTCPIPHeader();
 	bool			Read_TDC8HP_raw_format(unsigned __int64 &ui64TDC8HP_AbsoluteTimeStamp);
 	__int32			PCIGetTDC_TDC8HP_25psGroupMode(unsigned __int64 &ui64TDC8HPAbsoluteTimeStamp, __int32 count, unsigned __int32 * Buffer);
+	__int32			PCIGetTDC_TDC8HP_25psGroupMode_Reference(unsigned __int64 &ui64TDC8HPAbsoluteTimeStamp, __int32 count, unsigned __int32 * Buffer);
+	__int16			TDC8HP_word_table[256];		// by the top byte of a raw word: the channel of a hit or TDC8HP_WORD_*
+	__int32			TDC8HP_word_table_offset;	// channel_offset_for_rising_transitions of the table
+	__int32			TDC8HP_word_table_channels;	// num_channels of the table, -1=not built
+	void			Build_TDC8HP_word_table();
+	void			Handle_TDC8HP_LevelInfo(unsigned __int32 ui32DataWord);
+	void			Handle_TDC8HP_RollOver(unsigned __int32 ui32DataWord);
+	std::vector<LMF_checkpoint>	checkpoints;	// checkpoints[k] is before event k*checkpoint_interval
+	unsigned __int32	checkpoint_interval;
+	void			AddCheckpoint();
+	void			RestoreCheckpoint(unsigned __int64 k);
+	std::string		input_lmf_filename;
+	bool			GetInputFileStamp(unsigned __int64 &size, __int64 &mtime_ns);
 
 
 public:
@@ -1,42 +1,96 @@
+#include <algorithm>
+#include <climits>
+#include <memory>
 #include <TSystem.h>
 #include <TApplication.h>
 #include "SortWrapper.h"
 #include "SortRun.h"
+#include "SortDaemon.h"
+#include "../AnalysisExe/AnalysisRun.h"
+#include "../Core/StageTimer.h"
+#include "../Core/Logger.h"
+#include "../Core/Keyboard.h"
 
-__int32 my_kbhit(void) {
-  struct termios term, oterm;
-  __int32 fd = 0;
-  __int32 c = 0;
-  tcgetattr(fd, &oterm);
-  memcpy(&term, &oterm, sizeof(term));
-  term.c_lflag = term.c_lflag & (!ICANON);
-  term.c_cc[VMIN] = 0;
-  term.c_cc[VTIME] = 1;
-  tcsetattr(fd, TCSANOW, &term);
-  c = getchar();
-  tcsetattr(fd, TCSANOW, &oterm);
-  if (c == -1) return 0;
-  return c;
+// set the sorted hits of one detector to the event data of the fused analysis
+void loadSortedHits(Analysis::EventDataReader &reader, const bool isIon,
+                    const int n, const Analysis::SortRun::DataSet *p, const int maxN) {
+  typedef Analysis::EventDataReader R;
+  const int m = n < maxN ? n : maxN;
+  reader.setNumObjs(isIon ? R::IonNum : R::ElecNum) = m;
+  for (int i = 0; i < maxN; i++) {
+    const bool isReal = i < m;
+    reader.setEventDataAt(isIon ? R::IonX : R::ElecX, i) = isReal ? p[i].x : NAN;
+    reader.setEventDataAt(isIon ? R::IonY : R::ElecY, i) = isReal ? p[i].y : NAN;
+    reader.setEventDataAt(isIon ? R::IonT : R::ElecT, i) = isReal ? p[i].t : NAN;
+    reader.setFlagDataAt(isIon ? R::IonFlag : R::ElecFlag, i) = isReal ? p[i].flag : -1;
+  }
 }
 
+// a sorter parameter variant, sorted from the events of the base config to its own root file
+struct SortVariant {
+  std::string name;
+  Analysis::LMFWrapper *pLMF;
+  Analysis::SortWrapper *pIon, *pElec;
+  Analysis::SortRun *pRun;
+};
+
 int main(int argc, char *argv[]) {
   // Inform status
   if (argc < 2) {
     printf("Please provide a filename.\n");
-    printf("syntax: SortExe filename\n");
+    printf("syntax: SortExe filename [LMF filename [first event] [last event]]\n");
     printf("        This file will be sorted and\n");
     printf("        a new file will be written.\n");
+    printf("        The LMF filename overwrites the list of the config file,\n");
+    printf("        the events overwrite the event range, last event 0 = to the end.\n");
+    printf("        SortExe --convert-calibration-table source destination [quad]\n");
+    printf("        writes a text table in the binary format or a binary table in the text format.\n");
     return 0;
   }
-  if (argc > 2) {
+  if (std::string(argv[1]) == "--convert-calibration-table") {
+    // the text tables have the w layer only for hexanodes
+    if (argc < 4 || (argc == 5 && std::string(argv[4]) != "quad") || argc > 5) {
+      printf("syntax: SortExe --convert-calibration-table source destination [quad]\n");
+      return 1;
+    }
+    const bool b = convert_calibration_tables(argv[2], argv[3], argc != 5);
+    if (!b) printf("Could not convert %s to %s\n", argv[2], argv[3]);
+    return b ? 0 : 1;
+  }
+  if (argc > 5) {
     printf("Too many arguments\n");
-    printf("syntax: SortExe filename\n");
+    printf("syntax: SortExe filename [LMF filename [first event] [last event]]\n");
     printf("        This file will be sorted and\n");
     printf("        a new file will be written.\n");
+    printf("        The LMF filename overwrites the list of the config file,\n");
+    printf("        the events overwrite the event range, last event 0 = to the end.\n");
     return 0;
   }
   std::cout << "The exe file which place at " << argv[0] << ", is running now. " << std::endl;
   std::cout << "The configure file which place at " << argv[1] << ", is going to be read. " << std::endl;
+  // batch: sort only the given LMF file without canvases and without waiting for the keyboard,
+  // the workers of the service mode run like this
+  const bool isBatch = argc >= 3;
+  std::string configFilename = argv[1], batchLMFFilename;
+  // a part of the file, so the workers can split a file
+  const bool hasBatchRange = argc >= 4;
+  const unsigned long long batchFirstEvent = hasBatchRange ? std::strtoull(argv[3], nullptr, 10) : 0;
+  const unsigned long long batchLastEvent = argc == 5 ? std::strtoull(argv[4], nullptr, 10) : 0;
+  if (batchLastEvent > 0 && batchLastEvent <= batchFirstEvent) {
+    std::cout << "The event range is invalid." << std::endl;
+    return 1;
+  }
+  { // the paths before changing the working directory
+    char path[PATH_MAX];
+    if (realpath(argv[1], path)) configFilename = path;
+    if (isBatch) {
+      if (realpath(argv[2], path) == nullptr) {
+        std::cout << "The LMF file does not exist: " << argv[2] << std::endl;
+        return 1;
+      }
+      batchLMFFilename = path;
+    }
+  }
 
   // start the Root-Environment
   std::cout << "Opening the ROOT App... ";
@@ -70,24 +124,121 @@ int main(int argc, char *argv[]) {
     const auto base = pReader->getOpt<const char *>("base_config_file");
     if (base) pReader->appendDoc(Analysis::JSONReader::fromFile, *base);
   }
-  const auto isDrawingCanvases = pReader->get<bool>("draw_canvases");
+  // messages of the run go to the console and the log file
+  std::shared_ptr<spdlog::logger> pLog;
+  {
+    Analysis::LoggerConfig config;
+    config.isConsole = true;
+    std::string name = "sp8sort";
+    if (isBatch) name = batchLMFFilename.substr(batchLMFFilename.find_last_of('/') + 1);
+    pLog = Analysis::createLogger(name, Analysis::readLoggerConfig(*pReader, "log", config));
+    pLog->info("config: {}, pid: {}", configFilename, (int) getpid());
+  }
+  Analysis::LogStream logStream(pLog);
+  if (!isBatch && pReader->hasMember("watch")) { // service mode
+    char exe[PATH_MAX];
+    const ssize_t len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (len < 0) throw std::invalid_argument("Could not find the exe file!");
+    exe[len] = '\0';
+    Analysis::SortDaemon daemon(*pReader, "watch", exe, configFilename, pLog);
+    delete pReader;
+    pReader = nullptr;
+    const bool result = daemon.run([]() { return Analysis::kbhit() != 0; });
+    pLog->flush();
+    theRootApp.Terminate();
+    return result ? 0 : 1;
+  }
+  const auto isDrawingCanvases = !isBatch && pReader->get<bool>("draw_canvases");
   const auto maxElecHits = pReader->get<int>("maxium_of_electron_hits");
   const auto maxIonHits = pReader->get<int>("maxium_of_ion_hits");
   const auto bunchCh = pReader->get<int>("bunch_marker_ch") -1;
   auto bunchMaskRm = Analysis::readBunchMaskRm(*pReader, "remove_bunch_region");
+  const auto isMaskingBeforeSort = pReader->getBoolAtIfItIs("pre_sort_bunch_mask", false);
+  const auto isDeferringHists = pReader->getBoolAtIfItIs("histograms.deferred", false);
+  const auto isWritingTree = pReader->getBoolAtIfItIs("write_tree", true);
+  int treeQueueSize;
+  { // the tree is filled and compressed on a writer thread and optionally by the ROOT thread pool
+    const auto pQueueSize = pReader->getOpt<int>("tree_writer.queue_size");
+    const auto pIMT = pReader->getOpt<int>("tree_writer.implicit_mt_threads");
+    treeQueueSize = pQueueSize ? *pQueueSize : 0;
+    const int numIMT = pIMT ? *pIMT : 0;
+    if (treeQueueSize < 0 || numIMT < 0) throw std::invalid_argument("The config of the tree writer is invalid!");
+    if (treeQueueSize > 0) ROOT::EnableThreadSafety();
+    if (numIMT > 0) ROOT::EnableImplicitMT((unsigned) numIMT);
+  }
+  const auto pSnapshotFile = pReader->getOpt<const char *>("live_snapshot.file");
+  const auto pSnapshotInterval = pReader->getOpt<double>("live_snapshot.interval");
+  const std::string snapshotFilename = pSnapshotFile && !isBatch ? *pSnapshotFile : "";
+  const double snapshotInterval = pSnapshotInterval ? *pSnapshotInterval : 2;
+  Analysis::JSONReader *pAnaReader = nullptr;
+  { // the analysis of sp8ana fed with the sorted hits in memory
+    const auto anaConfig = pReader->getOpt<const char *>("fused_analysis");
+    if (anaConfig) {
+      pAnaReader = new Analysis::JSONReader();
+      // the first doc which has a key wins, so the numbers of hits follow the sorter
+      pAnaReader->appendDoc(Analysis::JSONReader::fromStr,
+                            "{\"setup_input\": {\"max_number_of_ion_hits\": " + std::to_string(maxIonHits)
+                            + ", \"max_number_of_electron_hits\": " + std::to_string(maxElecHits) + "}}");
+      pAnaReader->appendDoc(Analysis::JSONReader::fromFile, *anaConfig);
+      const auto base = pAnaReader->getOpt<const char *>("base_config_file");
+      if (base) pAnaReader->appendDoc(Analysis::JSONReader::fromFile, *base);
+    }
+  }
+  if (!isWritingTree && pAnaReader == nullptr) pLog->warn("The sorted hits are neither written nor analyzed.");
+  std::vector<std::string> disabledHistGroups;
 
   // Setup helpers
   Analysis::SortRun *pRun;
   Analysis::LMFWrapper aLMFWrapper;
   aLMFWrapper.readConfig(*pReader);
+  if (isBatch) {
+    aLMFWrapper.filenames = {batchLMFFilename};
+    aLMFWrapper.isFollowing = false;
+    if (hasBatchRange) {
+      aLMFWrapper.firstEvent = batchFirstEvent;
+      aLMFWrapper.lastEvent = batchLastEvent;
+    }
+  }
   Analysis::SortWrapper iSortWrapper(&aLMFWrapper), eSortWrapper(&aLMFWrapper);
   {
     bool b1, b2;
     b1 = iSortWrapper.readConfig(*pReader, "ion_sorter");
     b2 = eSortWrapper.readConfig(*pReader, "electron_sorter");
     if (!b1 || !b2) throw std::invalid_argument("Fail to read the config file!");
-    iSortWrapper.readCalibTab();
-    eSortWrapper.readCalibTab();
+    b1 = iSortWrapper.readCalibTab();
+    b2 = eSortWrapper.readCalibTab();
+    if (!b1 || !b2) throw std::invalid_argument("Fail to read the calibration tables!");
+    const int cmd = std::max(iSortWrapper.getCmd(), eSortWrapper.getCmd());
+    disabledHistGroups = Analysis::readDisabledHistGroups(*pReader, "histograms.disabled_groups", cmd);
+  }
+  std::vector<SortVariant> variants;
+  if (const auto pVariants = pReader->getOptValue("sort_variants")) {
+    if (!pVariants->IsArray()) throw std::invalid_argument("sort_variants has to be an array!");
+    for (const auto &patch : pVariants->GetArray()) {
+      if (!patch.IsObject() || !patch.HasMember("name") || !patch["name"].IsString()) {
+        throw std::invalid_argument("Each of sort_variants needs a name!");
+      }
+      std::unique_ptr<Analysis::JSONReader> pPatched(pReader->createPatched(patch));
+      SortVariant v;
+      v.name = patch["name"].GetString();
+      v.pLMF = new Analysis::LMFWrapper();
+      v.pLMF->readConfig(*pPatched);
+      v.pIon = new Analysis::SortWrapper(v.pLMF);
+      v.pElec = new Analysis::SortWrapper(v.pLMF);
+      v.pRun = nullptr;
+      bool b1, b2;
+      b1 = v.pIon->readConfig(*pPatched, "ion_sorter");
+      b2 = v.pElec->readConfig(*pPatched, "electron_sorter");
+      if (!b1 || !b2) throw std::invalid_argument("Fail to read the sort variant " + v.name + "!");
+      if (std::max(v.pIon->getCmd(), v.pElec->getCmd()) > Analysis::SortWrapper::kSort) {
+        throw std::invalid_argument("The sort variants can not calibrate the detectors!");
+      }
+      b1 = v.pIon->readCalibTab();
+      b2 = v.pElec->readCalibTab();
+      if (!b1 || !b2) throw std::invalid_argument("Fail to read the calibration tables of the sort variant " + v.name + "!");
+      variants.push_back(v);
+    }
+    pLog->info("{} sort variants are sorted with the base config.", variants.size());
   }
 
   // Close the JSON reader
@@ -101,12 +252,12 @@ int main(int argc, char *argv[]) {
   // Check cmd
   if (iSortWrapper.getCmd() > Analysis::SortWrapper::kSort
       && eSortWrapper.getCmd() > Analysis::SortWrapper::kSort) {
-    printf("Error: Do not calibrate 2 detectors simultaneously.\n");
+    pLog->error("Do not calibrate 2 detectors simultaneously.");
     return 0;
   }
   if (iSortWrapper.getCmd() == Analysis::SortWrapper::kNoDetector
       && eSortWrapper.getCmd() == Analysis::SortWrapper::kNoDetector) {
-    printf("no config file was read. Nothing to do.\n");
+    pLog->warn("no config file was read. Nothing to do.");
     return 0;
   }
 
@@ -116,8 +267,26 @@ int main(int argc, char *argv[]) {
     if (!result) throw std::invalid_argument("Fail to init the ion sorter!");
     result = eSortWrapper.init();
     if (!result) throw std::invalid_argument("Fail to init the electron sorter!");
+    aLMFWrapper.addRawChannel(bunchCh);
+    for (auto &v : variants) {
+      result = v.pIon->init() && v.pElec->init();
+      if (!result) throw std::invalid_argument("Fail to init the sort variant " + v.name + "!");
+      for (const int ch : v.pLMF->getCachedChannels()) aLMFWrapper.addRawChannel(ch);
+    }
   }
 
+  // Stage timers
+  enum {stageDecode, stageConvertTDC, stageSort, stageHistFill, stageTreeFill, stageAnalysis};
+  Analysis::StageTimer timer({"decode", "convertTDC", "sort", "hist_fill", "tree_fill", "analysis"});
+
+  // the root files of the batch are named after the LMF file, the workers would race for the ids
+  std::string rootPrefix = "ResortLess";
+  if (isBatch) {
+    rootPrefix = batchLMFFilename.substr(batchLMFFilename.find_last_of('/') + 1);
+    rootPrefix = rootPrefix.substr(0, rootPrefix.find_last_of('.')) + "_";
+    if (hasBatchRange) rootPrefix += std::to_string(batchFirstEvent) + "_";
+  }
+  int exitCode = 0;
   bool theLoopIsOn = true;
   const int numLMF = (const int) aLMFWrapper.filenames.size();
   for (int iLMF=0; iLMF < numLMF; iLMF++) {
@@ -127,56 +296,69 @@ int main(int argc, char *argv[]) {
     { // Read a LMF file
       bool result;
       result = aLMFWrapper.readFile(iLMF);
-      if (!result) break;
+      if (!result) {
+        pLog->error("Could not open the LMF file {}", aLMFWrapper.filenames[iLMF]);
+        exitCode = 1;
+        break;
+      }
     }
 
     // Setup Run
-    pRun = new Analysis::SortRun("ResortLess", maxIonHits, maxElecHits);
-    std::cout << "A root file is open for output." << std::endl;
+    pRun = new Analysis::SortRun(rootPrefix, maxIonHits, maxElecHits, isDeferringHists, disabledHistGroups,
+                                 isWritingTree, treeQueueSize);
+    pLog->info("LMF file: {}, root file: {}", aLMFWrapper.filenames[iLMF], pRun->getRootFilename());
+    for (auto &v : variants) {
+      v.pRun = new Analysis::SortRun(rootPrefix + v.name + "_", maxIonHits, maxElecHits, isDeferringHists,
+                                     disabledHistGroups, isWritingTree, treeQueueSize);
+      pLog->info("Sort variant {}, root file: {}", v.name, v.pRun->getRootFilename());
+    }
+    if (!snapshotFilename.empty()) {
+      pRun->setSnapshot(snapshotFilename, snapshotInterval);
+      pLog->info("The histograms are published to {} for sp8view.", snapshotFilename);
+    }
+    Analysis::AnalysisRun *pAnaRun = nullptr;
+    if (pAnaReader != nullptr) {
+      // the runs of the same second would share the file names, so they are named after the sorted root file
+      std::string stem = pRun->getRootFilename();
+      stem = stem.substr(0, stem.find_last_of('.'));
+      const std::string anaPrefix = pAnaReader->getStringAt("setup_output.filename_prefix");
+      const std::string name = anaPrefix.empty() ? stem : anaPrefix + "_" + stem;
+      rapidjson::Document renaming;
+      renaming.SetObject();
+      {
+        auto &allocator = renaming.GetAllocator();
+        rapidjson::Value output(rapidjson::kObjectType);
+        output.AddMember("filename_prefix", rapidjson::Value(name.c_str(), allocator), allocator);
+        renaming.AddMember("setup_output", output, allocator);
+      }
+      std::unique_ptr<Analysis::JSONReader> pRenamed(pAnaReader->createPatched(renaming));
+      pAnaRun = new Analysis::AnalysisRun(*pRenamed, true);
+      pLog->info("The sorted hits are analyzed in memory.");
+    }
+    const bool isFillingRaw = pRun->isHistGroupOn(Analysis::SortRun::kRawHists);
+    const bool isFillingTimesum = pRun->isHistGroupOn(Analysis::SortRun::kTimesumHists);
+    const bool isFillingIonEvents = pRun->isHistGroupOn(Analysis::SortRun::kIonEventHists);
+    const bool isFillingElecEvents = pRun->isHistGroupOn(Analysis::SortRun::kElecEventHists);
     if (isDrawingCanvases) {
       if (!iSortWrapper.isNull()) pRun->createC1();
       if (!eSortWrapper.isNull()) pRun->createC2();
     }
     gSystem->ProcessEvents(); // allow the system to show the histograms
 
-    // Start reading event data from input file:
-    // ("event" is all the data that was recorded after a trigger signal)
-    printf("reading event data... ");
-    while (true) {
-      {
-        auto &pLMF = aLMFWrapper.pLMF;
-        if (pLMF->GetEventNumber() % 20000 == 1) {
-          if (my_kbhit()) {
-            std::cout << "The keyboard is hit. Closing the program." << std::endl;
-            theLoopIsOn = false;
-            break;
-          }
-          gSystem->ProcessEvents(); // allow the system to show the histograms
-          printf("\rreading event data... %2i %c  ",
-                 __int32(100 * pLMF->GetEventNumber() / pLMF->uint64_Numberofevents),
-                 37);
-          if (pLMF->GetEventNumber() % 60000 == 1) {
-            pRun->updateC1();
-            pRun->updateC2();
-          }
-        }
-      }
-
-      { // read one new event data block from the file:
-        const bool b = aLMFWrapper.readNextEvent();
-        if (!b) {
-          std::cout << "Done with reading one LMF file." << std::endl;
-          break;
-        }
-      }
-
+    // convert, sort and fill one event for the base config or a variant, the event is decoded once
+    unsigned __int64 numSkippedSorts = 0;
+    auto sortEvent = [&](Analysis::LMFWrapper &aLMFWrapper,
+                         Analysis::SortWrapper &iSortWrapper, Analysis::SortWrapper &eSortWrapper,
+                         Analysis::SortRun *pRun, Analysis::AnalysisRun *pAnaRun) {
       // convert the raw TDC data to nanoseconds
+      aLMFWrapper.convertTDC();
       iSortWrapper.convertTDC();
       eSortWrapper.convertTDC();
+      timer.lap(stageConvertTDC);
 
       // fill raw data
-      pRun->fill1d(Analysis::SortRun::h1_timestamp, aLMFWrapper.timestamp);
-      { // TDC ns
+      if (isFillingRaw) { // TDC ns
+        pRun->fill1d(Analysis::SortRun::h1_timestamp, aLMFWrapper.timestamp);
         auto &tdc_ns = aLMFWrapper.TDCns;
         const int idxhist = Analysis::SortRun::h1_TDC01;
         const int numhist = 16;
@@ -186,7 +368,7 @@ int main(int argc, char *argv[]) {
       }
 
       // fill timesums before sort
-      if (!iSortWrapper.isNull()) { // ion
+      if (isFillingTimesum && !iSortWrapper.isNull()) { // ion
         const auto &wrapper = iSortWrapper;
         const auto u_timesum = wrapper.getUTimesum();
         const auto u_timediff = wrapper.getUTimediff();
@@ -205,7 +387,7 @@ int main(int argc, char *argv[]) {
         pRun->fill1d(Analysis::SortRun::h1_ionTimediffW_beforeSort, w_timediff);
         pRun->fill2d(Analysis::SortRun::h2_ionTimesumDiffW_beforeSort, w_timediff, w_timesum);
       }
-      if (!eSortWrapper.isNull()) { // electron
+      if (isFillingTimesum && !eSortWrapper.isNull()) { // electron
         const auto &wrapper = eSortWrapper;
         const auto u_timesum = wrapper.getUTimesum();
         const auto u_timediff = wrapper.getUTimediff();
@@ -224,12 +406,34 @@ int main(int argc, char *argv[]) {
         pRun->fill1d(Analysis::SortRun::h1_elecTimediffW_beforeSort, w_timediff);
         pRun->fill2d(Analysis::SortRun::h2_elecTimesumDiffW_beforeSort, w_timediff, w_timesum);
       }
+      timer.lap(stageHistFill);
+
+      // skip the sort of the events which can never be written, from the raw counts and TDC data
+      bool isRejected = !iSortWrapper.isPassingPreSortFilter() || !eSortWrapper.isPassingPreSortFilter();
+      if (isRejected || isMaskingBeforeSort) { // the same bunch marker as after the sort
+        const auto mcp = eSortWrapper.getMCP();
+        double bunchMarker = 0;
+        if (mcp != nullptr) {
+          const auto TDCRes = aLMFWrapper.TDCRes;
+          bunchMarker = *mcp - (aLMFWrapper.count[bunchCh] > 0 ? aLMFWrapper.getTDC(bunchCh)[0] * TDCRes : 0);
+        }
+        const double *pBunchMarker = mcp != nullptr ? &bunchMarker : nullptr;
+        if (!isRejected) isRejected = bunchMaskRm.isIn(pBunchMarker);
+        if (isRejected) {
+          // the bunch marker before the removal still counts every event
+          if (isFillingRaw && !eSortWrapper.isNull()) pRun->fill1d(Analysis::SortRun::h1_bunchMarker_beforeRm, pBunchMarker);
+          numSkippedSorts++;
+          return;
+        }
+      }
+
       // sort
       iSortWrapper.sort();
       eSortWrapper.sort();
+      timer.lap(stageSort);
 
       // fill timesums after sort
-      if (!iSortWrapper.isNull()) { // ion
+      if (isFillingTimesum && !iSortWrapper.isNull()) { // ion
         const auto &wrapper = iSortWrapper;
         const auto x_dev = wrapper.getXDev();
         const auto y_dev = wrapper.getYDev();
@@ -255,7 +459,7 @@ int main(int argc, char *argv[]) {
         pRun->fill1d(Analysis::SortRun::h1_ionTimediffW_afterSort, w_timediff);
         pRun->fill2d(Analysis::SortRun::h2_ionTimesumDiffW_afterSort, w_timediff, w_timesum);
       }
-      if (!eSortWrapper.isNull()) { // electron
+      if (isFillingTimesum && !eSortWrapper.isNull()) { // electron
         const auto &wrapper = eSortWrapper;
         const auto x_dev = wrapper.getXDev();
         const auto y_dev = wrapper.getYDev();
@@ -285,32 +489,34 @@ int main(int argc, char *argv[]) {
       // fill images
       const int numHitIons = iSortWrapper.getNumHits();
       const int numHitElecs = eSortWrapper.getNumHits();
-      for (int i=0; i<numHitIons; i++)
-        pRun->fill2d(Analysis::SortRun::h2_ionXY,
-                     iSortWrapper.getOutputArr()[i]->x,
-                     iSortWrapper.getOutputArr()[i]->y);
-      for (int i=0; i<numHitElecs; i++)
-        pRun->fill2d(Analysis::SortRun::h2_elecXY,
-                     eSortWrapper.getOutputArr()[i]->x,
-                     eSortWrapper.getOutputArr()[i]->y);
+      if (isFillingTimesum) {
+        for (int i=0; i<numHitIons; i++)
+          pRun->fill2d(Analysis::SortRun::h2_ionXY,
+                       iSortWrapper.getOutputArr()[i]->x,
+                       iSortWrapper.getOutputArr()[i]->y);
+        for (int i=0; i<numHitElecs; i++)
+          pRun->fill2d(Analysis::SortRun::h2_elecXY,
+                       eSortWrapper.getOutputArr()[i]->x,
+                       eSortWrapper.getOutputArr()[i]->y);
+      }
 
       // get bunch marker
       const double *pBunchMarker = nullptr;
       if (!eSortWrapper.isNull()) {
         const auto mcp = eSortWrapper.getMCP();
         if (mcp != nullptr) {
-          const auto &TDC = aLMFWrapper.TDC;
           const auto TDCRes = aLMFWrapper.TDCRes;
-          pBunchMarker = new auto(*mcp - TDC[bunchCh][0] * TDCRes);
+          const double bunchMarker = aLMFWrapper.count[bunchCh] > 0 ? aLMFWrapper.getTDC(bunchCh)[0] * TDCRes : 0;
+          pBunchMarker = new auto(*mcp - bunchMarker);
         }
-        pRun->fill1d(Analysis::SortRun::h1_bunchMarker_beforeRm, pBunchMarker);
+        if (isFillingRaw) pRun->fill1d(Analysis::SortRun::h1_bunchMarker_beforeRm, pBunchMarker);
       }
 
       // fill events
       if (!bunchMaskRm.isIn(pBunchMarker) // ignore events which bunch marker in certain region
           && numHitElecs > 0 && numHitIons > 0) { // ignore zero hit events
-        pRun->fill1d(Analysis::SortRun::h1_bunchMarker_afterRm, pBunchMarker);
-        { // ion
+        if (isFillingRaw) pRun->fill1d(Analysis::SortRun::h1_bunchMarker_afterRm, pBunchMarker);
+        if (isFillingIonEvents) { // ion
           const auto &wrapper = iSortWrapper;
           const auto x1 = wrapper.getNthX(0);
           const auto y1 = wrapper.getNthY(0);
@@ -368,7 +574,7 @@ int main(int argc, char *argv[]) {
           pRun->fill2d(Analysis::SortRun::h2_ion6hit7hitPIPICO, t6, t7);
           pRun->fill2d(Analysis::SortRun::h2_ion7hit8hitPIPICO, t7, t8);
         }
-        { // electron
+        if (isFillingElecEvents) { // electron
           const auto &wrapper = eSortWrapper;
           const auto x1 = wrapper.getNthX(0);
           const auto y1 = wrapper.getNthY(0);
@@ -426,6 +632,7 @@ int main(int argc, char *argv[]) {
           pRun->fill2d(Analysis::SortRun::h2_elec6hit7hitPEPECO, t6, t7);
           pRun->fill2d(Analysis::SortRun::h2_elec7hit8hitPEPECO, t7, t8);
         }
+        timer.lap(stageHistFill);
         { // fill tree
           Analysis::SortRun::DataSet *pIons, *pElecs;
           pIons = new Analysis::SortRun::DataSet[numHitIons];
@@ -443,6 +650,13 @@ int main(int argc, char *argv[]) {
             pElecs[i].flag = *eSortWrapper.getNthMethod(i);
           }
           pRun->fillTree(numHitIons, pIons, numHitElecs, pElecs);
+          timer.lap(stageTreeFill);
+          if (pAnaRun != nullptr) {
+            auto &reader = pAnaRun->getEventReader();
+            loadSortedHits(reader, true, numHitIons, pIons, pAnaRun->getMaxNumOfIonHits());
+            loadSortedHits(reader, false, numHitElecs, pElecs, pAnaRun->getMaxNumOfElecHits());
+            pAnaRun->processEvent();
+          }
           if (pIons) {
             delete[] pIons;
             pIons = nullptr;
@@ -452,49 +666,142 @@ int main(int argc, char *argv[]) {
             pElecs = nullptr;
           }
         }
+        timer.lap(stageAnalysis);
       }
+      timer.lap(stageHistFill);
+    };
+
+    // Start reading event data from input file:
+    // ("event" is all the data that was recorded after a trigger signal)
+    printf("reading event data... ");
+    timer.reset();
+    unsigned __int64 lastBytePosition = aLMFWrapper.getBytePosition();
+    while (true) {
+      {
+        const unsigned __int64 eventNumber = aLMFWrapper.getEventNumber();
+        if (eventNumber % 20000 == 1) {
+          if (Analysis::kbhit()) {
+            pLog->info("The keyboard is hit. Closing the program.");
+            theLoopIsOn = false;
+            break;
+          }
+          if (isDrawingCanvases) gSystem->ProcessEvents(); // allow the system to show the histograms
+          const unsigned __int64 numEvents = aLMFWrapper.getNumberOfEvents();
+          printf("\rreading event data... %2i %c  ", __int32(numEvents > 0 ? 100 * eventNumber / numEvents : 0), 37);
+          if (isDrawingCanvases && eventNumber % 60000 == 1) {
+            pRun->updateC1();
+            pRun->updateC2();
+          }
+          if (timer.report(logStream)) printf("reading event data... ");
+        }
+      }
+
+      timer.mark();
+      { // read one new event data block from the file:
+        const bool b = aLMFWrapper.readNextEvent();
+        if (!b && aLMFWrapper.isWaitingForData()) {
+          // follow mode: keep the histograms updated while the DAQ writes the file
+          pRun->updateC1();
+          pRun->updateC2();
+          pRun->publishSnapshot(true);
+          gSystem->ProcessEvents();
+          if (Analysis::kbhit()) {
+            pLog->info("The keyboard is hit. Closing the program.");
+            theLoopIsOn = false;
+            break;
+          }
+          if (aLMFWrapper.waitForData() != Analysis::LMFWrapper::kTimeout) continue;
+          pLog->warn("The LMF file did not grow for {} s.", aLMFWrapper.followTimeout);
+        }
+        if (!b) {
+          pLog->info("Done with reading {} events of the LMF file.", aLMFWrapper.getEventNumber());
+          break;
+        }
+        const unsigned __int64 bytePosition = aLMFWrapper.getBytePosition();
+        timer.countEvent(double(bytePosition - lastBytePosition));
+        lastBytePosition = bytePosition;
+      }
+      timer.lap(stageDecode);
+
+      sortEvent(aLMFWrapper, iSortWrapper, eSortWrapper, pRun, pAnaRun);
+      for (auto &v : variants) {
+        v.pLMF->shareEvent(aLMFWrapper);
+        sortEvent(*v.pLMF, *v.pIon, *v.pElec, v.pRun, nullptr);
+      }
+
+      pRun->publishSnapshot();
 
       { // check if it's full
         bool b1, b2;
         b1 = iSortWrapper.isFull();
-        b2 = iSortWrapper.isFull();
+        b2 = eSortWrapper.isFull();
         if (b1 || b2) {
-          std::cout << "ionSorter: map is full enough" << std::endl;
+          pLog->info("ionSorter: map is full enough");
           theLoopIsOn = false;
           break;
         }
       }
     } // end of the loop reading events
     printf("ok\n");
+    if (numSkippedSorts > 0) pLog->info("The pre-sort filter skipped {} sorts.", numSkippedSorts);
 
     // calib
+    iSortWrapper.finishCalibWorker();
+    eSortWrapper.finishCalibWorker();
     iSortWrapper.calibFactors();
     eSortWrapper.calibFactors();
     iSortWrapper.genClibTab();
     eSortWrapper.genClibTab();
 
+    // timing summary next to the root file
+    timer.report(logStream, true);
+    if (pRun != nullptr) {
+      std::string filename = pRun->getRootFilename();
+      filename = filename.substr(0, filename.find_last_of('.')) + "_timing.json";
+      if (!timer.writeJSON(filename)) pLog->error("Could not write {}", filename);
+    }
+
     // cleanup
+    if (pAnaRun != nullptr) {
+      delete pAnaRun;
+      pAnaRun = nullptr;
+    }
     if (pRun != nullptr) {
+      pRun->publishSnapshot(true);
       pRun->updateC1(true);
       pRun->updateC2(true);
       delete pRun;
       pRun = nullptr;
     }
+    for (auto &v : variants) {
+      delete v.pRun;
+      v.pRun = nullptr;
+    }
     aLMFWrapper.cleanup();
   } // end of the loop reading LMF files
+  for (auto &v : variants) {
+    delete v.pIon;
+    delete v.pElec;
+    delete v.pLMF;
+  }
+  if (pAnaReader != nullptr) {
+    delete pAnaReader;
+    pAnaReader = nullptr;
+  }
 
-  printf("hit any key to exit\n");
-  while (true) {
+  if (!isBatch) printf("hit any key to exit\n");
+  while (!isBatch) {
     gSystem->Sleep(5);
     gSystem->ProcessEvents();
-    if (my_kbhit()) {
+    if (Analysis::kbhit()) {
       break;
     }
   }
 
   // Finish the program
-  printf("terminating the root app.\n");
+  pLog->info("terminating the root app.");
+  pLog->flush();
   theRootApp.Terminate();
   std::cout << "The program is done. " << std::endl;
-  return 0;
+  return exitCode;
 }
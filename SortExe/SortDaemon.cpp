@@ -0,0 +1,221 @@
+#include "SortDaemon.h"
+#include <fstream>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <dirent.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+Analysis::SortDaemon::SortDaemon(const Analysis::JSONReader &reader, const std::string prefix,
+                                 const std::string exe, const std::string config,
+                                 std::shared_ptr<spdlog::logger> pLog)
+    : pLog(pLog), exeFilename(exe), configFilename(config) {
+  {
+    const std::string dir = reader.getStringAt(prefix + ".directory");
+    char path[PATH_MAX];
+    if (realpath(dir.c_str(), path) == nullptr)
+      throw std::invalid_argument("The directory to watch does not exist: " + dir);
+    directory = path;
+  }
+  const auto pPattern = reader.getOpt<const char *>(prefix + ".pattern");
+  pattern = pPattern ? *pPattern : "*.lmf";
+  const auto pRecord = reader.getOpt<const char *>(prefix + ".record_file");
+  recordFilename = pRecord ? *pRecord : "sorted_LMF_files.txt";
+  const auto pWorkers = reader.getOpt<int>(prefix + ".workers");
+  numWorkers = pWorkers ? *pWorkers : 1;
+  if (numWorkers < 1) throw std::invalid_argument("The number of workers is invalid!");
+  const auto pSettle = reader.getOpt<double>(prefix + ".settle_time");
+  settleTime = pSettle ? *pSettle : 2;
+  if (settleTime < 0) throw std::invalid_argument("The settle time is invalid!");
+  // the calibration tables of the files would overwrite each other
+  for (const auto sorter : {"ion_sorter", "electron_sorter"}) {
+    const std::string key = std::string(sorter) + ".cmd";
+    if (reader.hasMember(key) && reader.get<int>(key) > 1)
+      throw std::invalid_argument("Do not calibrate the detectors in the service mode!");
+  }
+}
+bool Analysis::SortDaemon::isMatching(const std::string &name) const {
+  return fnmatch(pattern.c_str(), name.c_str(), 0) == 0;
+}
+void Analysis::SortDaemon::readRecord() {
+  std::ifstream file(recordFilename);
+  std::string line;
+  while (std::getline(file, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (!line.empty()) known.insert(line);
+  }
+}
+void Analysis::SortDaemon::appendRecord(const std::string &filename) const {
+  std::ofstream file(recordFilename, std::ios::app);
+  file << filename << std::endl;
+  if (!file) pLog->error("Could not write {}", recordFilename);
+}
+void Analysis::SortDaemon::enqueue(const std::string &name) {
+  if (!isMatching(name)) return;
+  const std::string filename = directory + "/" + name;
+  if (!known.insert(filename).second) return;
+  queue.push_back(filename);
+  pLog->info("Queued {}", filename);
+}
+bool Analysis::SortDaemon::isOpenForWriting(const std::string &filename) const {
+  // the fds of the processes of other users can not be read, the growth check covers them
+  DIR *pProc = opendir("/proc");
+  if (pProc == nullptr) return false;
+  bool isOpen = false;
+  while (const dirent *pProcess = readdir(pProc)) {
+    const std::string pid = pProcess->d_name;
+    if (isOpen || pid.find_first_not_of("0123456789") != std::string::npos) continue;
+    DIR *pFds = opendir(("/proc/" + pid + "/fd").c_str());
+    if (pFds == nullptr) continue;
+    while (const dirent *pFd = readdir(pFds)) {
+      const std::string fd = pFd->d_name;
+      if (fd[0] == '.') continue;
+      char target[PATH_MAX];
+      const ssize_t len = readlink(("/proc/" + pid + "/fd/" + fd).c_str(), target, sizeof(target) - 1);
+      if (len < 0) continue;
+      target[len] = '\0';
+      if (filename != target) continue;
+      std::ifstream info("/proc/" + pid + "/fdinfo/" + fd);
+      std::string key;
+      while (info >> key) {
+        if (key != "flags:") continue;
+        std::string flags;
+        info >> flags;
+        if ((std::strtol(flags.c_str(), nullptr, 8) & O_ACCMODE) != O_RDONLY) isOpen = true;
+        break;
+      }
+      if (isOpen) break;
+    }
+    closedir(pFds);
+  }
+  closedir(pProc);
+  return isOpen;
+}
+void Analysis::SortDaemon::scanDirectory() {
+  DIR *pDir = opendir(directory.c_str());
+  if (pDir == nullptr) return;
+  std::map<std::string, struct stat> found;
+  while (const dirent *pEntry = readdir(pDir)) {
+    const std::string name = pEntry->d_name;
+    if (!isMatching(name) || known.count(directory + "/" + name) > 0) continue;
+    struct stat st;
+    if (stat((directory + "/" + name).c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+    found[name] = st;
+  }
+  closedir(pDir);
+  // the DAQ may be writing a file since before the start, its IN_CLOSE_WRITE queues it
+  if (!found.empty() && settleTime > 0) std::this_thread::sleep_for(std::chrono::duration<double>(settleTime));
+  for (const auto &kv : found) { // sorted by name
+    const std::string filename = directory + "/" + kv.first;
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0) continue;
+    if (st.st_size != kv.second.st_size || st.st_mtime != kv.second.st_mtime || isOpenForWriting(filename)) {
+      pLog->info("{} is still written, it is queued when it is closed", filename);
+      continue;
+    }
+    enqueue(kv.first);
+  }
+}
+bool Analysis::SortDaemon::startWorker() {
+  const std::string filename = queue.front();
+  std::string logFilename = filename.substr(filename.find_last_of('/') + 1);
+  logFilename = logFilename.substr(0, logFilename.find_last_of('.')) + ".log";
+  const pid_t pid = fork();
+  if (pid < 0) {
+    pLog->error("Could not start a worker for {}", filename);
+    return false;
+  }
+  if (pid == 0) { // worker: the keyboard belongs to the daemon, the output goes to the log
+    const int in = open("/dev/null", O_RDONLY);
+    const int out = open(logFilename.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (in >= 0) dup2(in, STDIN_FILENO);
+    if (out >= 0) {
+      dup2(out, STDOUT_FILENO);
+      dup2(out, STDERR_FILENO);
+    }
+    execl(exeFilename.c_str(), exeFilename.c_str(), configFilename.c_str(), filename.c_str(), (char *) nullptr);
+    _exit(127);
+  }
+  queue.pop_front();
+  running[pid] = filename;
+  pLog->info("Sorting {} (log: {})", filename, logFilename);
+  return true;
+}
+void Analysis::SortDaemon::reapWorkers(const bool isBlocking) {
+  for (auto it = running.begin(); it != running.end();) {
+    int status;
+    const pid_t pid = waitpid(it->first, &status, isBlocking ? 0 : WNOHANG);
+    if (pid == 0 || (pid < 0 && errno == EINTR)) {
+      ++it;
+      continue;
+    }
+    if (pid > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+      appendRecord(it->second);
+      pLog->info("Sorted {}", it->second);
+    } else {
+      // not recorded, it is sorted again if the file is written again or after a restart
+      known.erase(it->second);
+      pLog->error("Failed to sort {}", it->second);
+    }
+    it = running.erase(it);
+  }
+}
+bool Analysis::SortDaemon::run(const std::function<bool()> isStopping) {
+  readRecord();
+  const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0) {
+    pLog->error("Could not init inotify.");
+    return false;
+  }
+  // only closed or moved files, so the DAQ is done with them
+  if (inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF) < 0) {
+    pLog->error("Could not watch {}", directory);
+    close(fd);
+    return false;
+  }
+  scanDirectory();
+  pLog->info("Watching {} for {} with {} workers. Hit any key to stop.", directory, pattern, numWorkers);
+
+  alignas(inotify_event) char buffer[4096];
+  bool isWatching = true;
+  while (isWatching && !isStopping()) {
+    reapWorkers(false);
+    while ((int) running.size() < numWorkers && !queue.empty()) {
+      if (!startWorker()) break;
+    }
+
+    pollfd p = {fd, POLLIN, 0};
+    const int n = poll(&p, 1, 500);
+    if (n < 0 && errno != EINTR) break;
+    if (n <= 0) continue;
+    ssize_t len;
+    while ((len = read(fd, buffer, sizeof(buffer))) > 0) {
+      for (const char *ptr = buffer; ptr < buffer + len;) {
+        const auto *pEvent = (const inotify_event *) ptr;
+        if (pEvent->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+          pLog->error("The watched directory is gone.");
+          isWatching = false;
+        } else if (pEvent->len > 0 && !(pEvent->mask & IN_ISDIR)) {
+          enqueue(pEvent->name);
+        }
+        ptr += sizeof(inotify_event) + pEvent->len;
+      }
+    }
+  }
+  close(fd);
+
+  if (!running.empty()) pLog->info("Waiting for {} running workers...", running.size());
+  while (!running.empty()) reapWorkers(true);
+  if (!queue.empty()) pLog->warn("{} files are left in the queue.", queue.size());
+  return true;
+}
@@ -0,0 +1,50 @@
+#ifndef ANALYSIS_SORTDAEMON_H
+#define ANALYSIS_SORTDAEMON_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <set>
+#include <map>
+#include <functional>
+#include <memory>
+#include <sys/types.h>
+#include "../Core/JSONReader.h"
+#include "../Core/Logger.h"
+
+namespace Analysis {
+// Service mode of sp8sort: watches a directory with inotify and sorts every new
+// LMF file matching a pattern, one sp8sort process per file with the same config.
+// At most "workers" files are sorted at once, ROOT files and the sorters are
+// not shared between them. Files sorted successfully are appended to a record
+// file and are never queued again, also after a restart. The files found at the
+// start which are still open for writing or growing are left to their close event.
+class SortDaemon {
+  std::shared_ptr<spdlog::logger> pLog;
+  std::string exeFilename; // sp8sort itself
+  std::string configFilename;
+  std::string directory;
+  std::string pattern;
+  std::string recordFilename;
+  int numWorkers;
+  double settleTime; // [s] the sizes of the files found at the start are compared over
+  std::set<std::string> known; // recorded, queued or running
+  std::deque<std::string> queue;
+  std::map<pid_t, std::string> running;
+  bool isMatching(const std::string &name) const;
+  void readRecord();
+  void appendRecord(const std::string &filename) const;
+  void enqueue(const std::string &name);
+  bool isOpenForWriting(const std::string &filename) const;
+  void scanDirectory();
+  bool startWorker();
+  void reapWorkers(const bool isBlocking);
+ public:
+  SortDaemon(const JSONReader &reader, const std::string prefix,
+             const std::string exe, const std::string config, std::shared_ptr<spdlog::logger> pLog);
+  // returns when isStopping returns true, after the running workers are done
+  bool run(const std::function<bool()> isStopping);
+};
+}
+
+#endif //ANALYSIS_SORTDAEMON_H
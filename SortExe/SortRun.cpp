@@ -23,6 +23,29 @@ Analysis::Regions<double> Analysis::readBunchMaskRm(const Analysis::JSONReader &
     return mask;
   } else return mask;
 }
+std::vector<std::string> Analysis::readDisabledHistGroups(const Analysis::JSONReader &reader,
+                                                         const std::string prefix,
+                                                         const int cmd) {
+  std::vector<std::string> groups;
+  std::string cmdName;
+  if (cmd <= 0) cmdName = "only_convert";
+  else if (cmd == 1) cmdName = "sort";
+  else if (cmd == 2) cmdName = "calib";
+  else cmdName = "gen_calib_tab";
+  auto pArr = reader.getOptArr<const char *>(prefix + "." + cmdName);
+  if (pArr) for (auto str : *pArr) groups.push_back(str);
+  return groups;
+}
+Analysis::SortRun::HistGroup Analysis::SortRun::getHistGroup(const std::string name) {
+  if (name == "raw") return kRawHists;
+  if (name == "timesum") return kTimesumHists;
+  if (name == "ion_events") return kIonEventHists;
+  if (name == "elec_events") return kElecEventHists;
+  throw std::invalid_argument("Invalid histogram group: " + name);
+}
+const bool Analysis::SortRun::isHistGroupOn(const HistGroup g) const {
+  return histGroupOn[g];
+}
 bool Analysis::SortRun::isFileExist(const char *fileName) {
   std::ifstream file(fileName);
   return file.good();
@@ -40,9 +63,16 @@ Analysis::SortRun::~SortRun() {
   if (pElecDataSet) delete[] pElecDataSet;
 }
 
-Analysis::SortRun::SortRun(const std::string prfx, const int iNum, const int eNum)
+Analysis::SortRun::SortRun(const std::string prfx, const int iNum, const int eNum,
+                           const bool deferHists, const std::vector<std::string> disabledHistGroups,
+                           const bool writeTree, const int treeQueueSize)
     : Hist(false, numHists),
       prefix(prfx), maxNumOfIons(iNum), maxNumOfElecs(eNum) {
+  // Setup hist options
+  for (int i = 0; i < numHistGroups; i++) histGroupOn[i] = true;
+  for (auto name : disabledHistGroups) histGroupOn[getHistGroup(name)] = false;
+  setDeferred2d(deferHists);
+
   // Create id
   for (int i = 0; i < 10000; i++) {
     sprintf(id, "%04d", i);
@@ -57,19 +87,72 @@ Analysis::SortRun::SortRun(const std::string prfx, const int iNum, const int eNu
 
   // Setup ROOT
   openRootFile(rootFilename.c_str(), "NEW");
-  createTree();
+  if (writeTree) createTree();
   createHists();
+
+  // Setup the tree writer
+  queueHead = 0;
+  queueTail = 0;
+  isWriterStopping = false;
+  if (writeTree && treeQueueSize > 0) {
+    this->treeQueueSize = treeQueueSize;
+    queuedIonNums.resize(treeQueueSize);
+    queuedElecNums.resize(treeQueueSize);
+    queuedIons.resize((size_t) treeQueueSize * maxNumOfIons);
+    queuedElecs.resize((size_t) treeQueueSize * maxNumOfElecs);
+    treeWriter = std::thread(&SortRun::runTreeWriter, this);
+  }
+}
+
+const std::string Analysis::SortRun::getRootFilename() const {
+  return rootFilename;
 }
 
 void Analysis::SortRun::fillTree(const int ionHitNum, const DataSet *pIons,
                                  const int elecHitNum, const DataSet *pElecs) {
+  if (!existTree()) return;
+  if (treeQueueSize == 0) {
+    copyToBranches(ionHitNum, pIons, elecHitNum, pElecs);
+    pRootTree->Fill();
+    return;
+  }
+  const long head = queueHead.load(std::memory_order_relaxed);
+  while (head - queueTail.load(std::memory_order_acquire) >= treeQueueSize) std::this_thread::yield(); // full
+  const long k = head % treeQueueSize;
+  queuedIonNums[k] = ionHitNum < maxNumOfIons ? ionHitNum : maxNumOfIons;
+  std::copy(pIons, pIons + queuedIonNums[k], &queuedIons[k * maxNumOfIons]);
+  queuedElecNums[k] = elecHitNum < maxNumOfElecs ? elecHitNum : maxNumOfElecs;
+  std::copy(pElecs, pElecs + queuedElecNums[k], &queuedElecs[k * maxNumOfElecs]);
+  queueHead.store(head + 1, std::memory_order_release);
+}
+void Analysis::SortRun::runTreeWriter() {
+  long tail = queueTail.load(std::memory_order_relaxed);
+  while (true) {
+    if (tail == queueHead.load(std::memory_order_acquire)) { // empty
+      if (isWriterStopping.load(std::memory_order_acquire) && tail == queueHead.load(std::memory_order_acquire)) break;
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+      continue;
+    }
+    const long k = tail % treeQueueSize;
+    copyToBranches(queuedIonNums[k], &queuedIons[k * maxNumOfIons],
+                   queuedElecNums[k], &queuedElecs[k * maxNumOfElecs]);
+    pRootTree->Fill();
+    queueTail.store(++tail, std::memory_order_release);
+  }
+}
+void Analysis::SortRun::stopTreeWriter() {
+  if (!treeWriter.joinable()) return;
+  isWriterStopping = true;
+  treeWriter.join();
+}
+void Analysis::SortRun::copyToBranches(const int ionHitNum, const DataSet *pIons,
+                                       const int elecHitNum, const DataSet *pElecs) {
   numOfIons = ionHitNum < maxNumOfIons ? ionHitNum : maxNumOfIons;
   for (int i = 0; i < numOfIons; i++) pIonDataSet[i] = pIons[i];
   for (int i = numOfIons; i < maxNumOfIons; i++) pIonDataSet[i] = dumpData;
   numOfElecs = elecHitNum < maxNumOfElecs ? elecHitNum : maxNumOfElecs;
   for (int i = 0; i < numOfElecs; i++) pElecDataSet[i] = pElecs[i];
   for (int i = numOfElecs; i < maxNumOfElecs; i++) pElecDataSet[i] = dumpData;
-  if (existTree()) pRootTree->Fill();
 }
 const bool Analysis::SortRun::existTree() const {
   return pRootTree != nullptr;
@@ -92,7 +175,7 @@ void Analysis::SortRun::createTree() {
   }
   // Electron setup
   str = "Elec";
-  pElecDataSet = new DataSet[maxNumOfIons];
+  pElecDataSet = new DataSet[maxNumOfElecs];
   pRootTree->Branch((str + "Num").c_str(), &numOfElecs, (str + "Num/I").c_str());
   for (int i = 0; i < maxNumOfElecs; i++) {
     char ch[2];
@@ -118,145 +201,153 @@ void Analysis::SortRun::createHists() {
 #define __TIMEDELAY_TITLE_BIN_REGION__ "Time [ns]", 1000, -250, 250, "timesum"
 #define __TIMESUMDIFF_TITLE_BIN_REGION__ "Time diff [ns]", "Time sum [ns]", 500, -250, 250, 500, -25, 25, "timesum"
 #define __AFTERCALIB_TITLE_BIN_REGION__(X) "Time1 [ns]", "Time2 [ns]", X*2, -X, X, X*2, -X, X, "timesum"
-  create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimesumU_beforeSort), __TIMESUM_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimesumV_beforeSort), __TIMESUM_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimesumW_beforeSort), __TIMESUM_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimediffU_beforeSort), __TIMEDELAY_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimediffV_beforeSort), __TIMEDELAY_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimediffW_beforeSort), __TIMEDELAY_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ionTimesumDiffU_beforeSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ionTimesumDiffV_beforeSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ionTimesumDiffW_beforeSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimesumU_afterSort), __TIMESUM_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimesumV_afterSort), __TIMESUM_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimesumW_afterSort), __TIMESUM_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimediffU_afterSort), __TIMEDELAY_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimediffV_afterSort), __TIMEDELAY_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimediffW_afterSort), __TIMEDELAY_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ionTimesumDiffU_afterSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ionTimesumDiffV_afterSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ionTimesumDiffW_afterSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ionXYRaw), __AFTERCALIB_TITLE_BIN_REGION__(60));
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ionXY), __AFTERCALIB_TITLE_BIN_REGION__(60));
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ionXYDev), __AFTERCALIB_TITLE_BIN_REGION__(100));
-  create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimesumU_beforeSort), __TIMESUM_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimesumV_beforeSort), __TIMESUM_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimesumW_beforeSort), __TIMESUM_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimediffU_beforeSort), __TIMEDELAY_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimediffV_beforeSort), __TIMEDELAY_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimediffW_beforeSort), __TIMEDELAY_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elecTimesumDiffU_beforeSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elecTimesumDiffV_beforeSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elecTimesumDiffW_beforeSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimesumU_afterSort), __TIMESUM_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimesumV_afterSort), __TIMESUM_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimesumW_afterSort), __TIMESUM_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimediffU_afterSort), __TIMEDELAY_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimediffV_afterSort), __TIMEDELAY_TITLE_BIN_REGION__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimediffW_afterSort), __TIMEDELAY_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elecTimesumDiffU_afterSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elecTimesumDiffV_afterSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elecTimesumDiffW_afterSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elecXYRaw), __AFTERCALIB_TITLE_BIN_REGION__(60));
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elecXY), __AFTERCALIB_TITLE_BIN_REGION__(60));
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elecXYDev), __AFTERCALIB_TITLE_BIN_REGION__(100));
+  if (isHistGroupOn(kTimesumHists)) {
+    create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimesumU_beforeSort), __TIMESUM_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimesumV_beforeSort), __TIMESUM_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimesumW_beforeSort), __TIMESUM_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimediffU_beforeSort), __TIMEDELAY_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimediffV_beforeSort), __TIMEDELAY_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimediffW_beforeSort), __TIMEDELAY_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ionTimesumDiffU_beforeSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ionTimesumDiffV_beforeSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ionTimesumDiffW_beforeSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimesumU_afterSort), __TIMESUM_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimesumV_afterSort), __TIMESUM_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimesumW_afterSort), __TIMESUM_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimediffU_afterSort), __TIMEDELAY_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimediffV_afterSort), __TIMEDELAY_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_ionTimediffW_afterSort), __TIMEDELAY_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ionTimesumDiffU_afterSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ionTimesumDiffV_afterSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ionTimesumDiffW_afterSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ionXYRaw), __AFTERCALIB_TITLE_BIN_REGION__(60));
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ionXY), __AFTERCALIB_TITLE_BIN_REGION__(60));
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ionXYDev), __AFTERCALIB_TITLE_BIN_REGION__(100));
+    create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimesumU_beforeSort), __TIMESUM_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimesumV_beforeSort), __TIMESUM_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimesumW_beforeSort), __TIMESUM_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimediffU_beforeSort), __TIMEDELAY_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimediffV_beforeSort), __TIMEDELAY_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimediffW_beforeSort), __TIMEDELAY_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elecTimesumDiffU_beforeSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elecTimesumDiffV_beforeSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elecTimesumDiffW_beforeSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimesumU_afterSort), __TIMESUM_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimesumV_afterSort), __TIMESUM_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimesumW_afterSort), __TIMESUM_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimediffU_afterSort), __TIMEDELAY_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimediffV_afterSort), __TIMEDELAY_TITLE_BIN_REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_elecTimediffW_afterSort), __TIMEDELAY_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elecTimesumDiffU_afterSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elecTimesumDiffV_afterSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elecTimesumDiffW_afterSort), __TIMESUMDIFF_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elecXYRaw), __AFTERCALIB_TITLE_BIN_REGION__(60));
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elecXY), __AFTERCALIB_TITLE_BIN_REGION__(60));
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elecXYDev), __AFTERCALIB_TITLE_BIN_REGION__(100));
+  }
 
 #define __TIMESTAMP__TITLE__BIN__REGION__ "Time [s]", 4000, 0, 4000
-  create1d(SAME_TITLE_WITH_VALNAME(h1_timestamp), __TIMESTAMP__TITLE__BIN__REGION__);
-
 #define __TDC_NS__ "Time [ns]", 1000, -500, 500, "TDC"
 #define __BUNCHMARKER__ "Time [ns]", 2000, -7500, 2500, "TDC"
-  create1d(SAME_TITLE_WITH_VALNAME(h1_TDC01), __TDC_NS__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_TDC02), __TDC_NS__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_TDC03), __TDC_NS__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_TDC04), __TDC_NS__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_TDC05), __TDC_NS__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_TDC06), __TDC_NS__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_TDC07), __TDC_NS__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_TDC08), __TDC_NS__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_TDC09), __TDC_NS__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_TDC10), __TDC_NS__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_TDC11), __TDC_NS__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_TDC12), __TDC_NS__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_TDC13), __TDC_NS__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_TDC14), __TDC_NS__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_TDC15), __TDC_NS__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_TDC16), __TDC_NS__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_bunchMarker_beforeRm), __BUNCHMARKER__);
-  create1d(SAME_TITLE_WITH_VALNAME(h1_bunchMarker_afterRm), __BUNCHMARKER__);
+  if (isHistGroupOn(kRawHists)) {
+    create1d(SAME_TITLE_WITH_VALNAME(h1_timestamp), __TIMESTAMP__TITLE__BIN__REGION__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_TDC01), __TDC_NS__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_TDC02), __TDC_NS__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_TDC03), __TDC_NS__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_TDC04), __TDC_NS__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_TDC05), __TDC_NS__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_TDC06), __TDC_NS__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_TDC07), __TDC_NS__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_TDC08), __TDC_NS__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_TDC09), __TDC_NS__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_TDC10), __TDC_NS__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_TDC11), __TDC_NS__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_TDC12), __TDC_NS__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_TDC13), __TDC_NS__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_TDC14), __TDC_NS__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_TDC15), __TDC_NS__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_TDC16), __TDC_NS__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_bunchMarker_beforeRm), __BUNCHMARKER__);
+    create1d(SAME_TITLE_WITH_VALNAME(h1_bunchMarker_afterRm), __BUNCHMARKER__);
+  }
 
 #define __ION_FISH_TITLE_BIN_REGION__ "TIME [ns]", "Location [mm]", 500, -3000, 12000, 200, -100, 100, "ion"
 #define __ION_XY_TITLE_BIN_REGION__ "Location X [mm]", "Location Y [mm]", 200, -100, 100, 200, -100, 100, "ion"
 #define __ION_PIPICO_TITLE_BIN_REGION__ "Time 1 [ns]", "Time 2 [ns]", 500, -3000, 12000, 500, -3000, 12000, "ion"
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion1hitXFish), __ION_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion1hitYFish), __ION_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion1hitXY), __ION_XY_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion2hitXFish), __ION_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion2hitYFish), __ION_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion2hitXY), __ION_XY_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion3hitXFish), __ION_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion3hitYFish), __ION_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion3hitXY), __ION_XY_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion4hitXFish), __ION_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion4hitYFish), __ION_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion4hitXY), __ION_XY_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion5hitXFish), __ION_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion5hitYFish), __ION_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion5hitXY), __ION_XY_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion6hitXFish), __ION_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion6hitYFish), __ION_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion6hitXY), __ION_XY_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion7hitXFish), __ION_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion7hitYFish), __ION_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion7hitXY), __ION_XY_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion8hitXFish), __ION_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion8hitYFish), __ION_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion8hitXY), __ION_XY_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion1hit2hitPIPICO), __ION_PIPICO_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion2hit3hitPIPICO), __ION_PIPICO_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion3hit4hitPIPICO), __ION_PIPICO_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion4hit5hitPIPICO), __ION_PIPICO_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion5hit6hitPIPICO), __ION_PIPICO_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion6hit7hitPIPICO), __ION_PIPICO_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_ion7hit8hitPIPICO), __ION_PIPICO_TITLE_BIN_REGION__);
+  if (isHistGroupOn(kIonEventHists)) {
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion1hitXFish), __ION_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion1hitYFish), __ION_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion1hitXY), __ION_XY_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion2hitXFish), __ION_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion2hitYFish), __ION_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion2hitXY), __ION_XY_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion3hitXFish), __ION_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion3hitYFish), __ION_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion3hitXY), __ION_XY_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion4hitXFish), __ION_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion4hitYFish), __ION_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion4hitXY), __ION_XY_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion5hitXFish), __ION_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion5hitYFish), __ION_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion5hitXY), __ION_XY_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion6hitXFish), __ION_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion6hitYFish), __ION_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion6hitXY), __ION_XY_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion7hitXFish), __ION_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion7hitYFish), __ION_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion7hitXY), __ION_XY_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion8hitXFish), __ION_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion8hitYFish), __ION_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion8hitXY), __ION_XY_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion1hit2hitPIPICO), __ION_PIPICO_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion2hit3hitPIPICO), __ION_PIPICO_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion3hit4hitPIPICO), __ION_PIPICO_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion4hit5hitPIPICO), __ION_PIPICO_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion5hit6hitPIPICO), __ION_PIPICO_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion6hit7hitPIPICO), __ION_PIPICO_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_ion7hit8hitPIPICO), __ION_PIPICO_TITLE_BIN_REGION__);
+  }
 
 #define __ELEC_FISH_TITLE_BIN_REGION__ "TIME [ns]", "Location [mm]", 1500, -1000, 500, 200, -100, 100, "electron"
 #define __ELEC_XY_TITLE_BIN_REGION__ "Location X [mm]", "Location Y [mm]", 200, -100, 100, 200, -100, 100, "electron"
 #define __ELEC_PIPICO_TITLE_BIN_REGION__ "Time 1 [ns]", "Time 2 [ns]", 1500, -1000, 500, 1500, -1000, 500, "electron"
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec1hitXFish), __ELEC_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec1hitYFish), __ELEC_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec1hitXY), __ELEC_XY_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec2hitXFish), __ELEC_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec2hitYFish), __ELEC_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec2hitXY), __ELEC_XY_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec3hitXFish), __ELEC_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec3hitYFish), __ELEC_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec3hitXY), __ELEC_XY_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec4hitXFish), __ELEC_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec4hitYFish), __ELEC_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec4hitXY), __ELEC_XY_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec5hitXFish), __ELEC_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec5hitYFish), __ELEC_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec5hitXY), __ELEC_XY_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec6hitXFish), __ELEC_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec6hitYFish), __ELEC_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec6hitXY), __ELEC_XY_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec7hitXFish), __ELEC_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec7hitYFish), __ELEC_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec7hitXY), __ELEC_XY_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec8hitXFish), __ELEC_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec8hitYFish), __ELEC_FISH_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec8hitXY), __ELEC_XY_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec1hit2hitPEPECO), __ELEC_PIPICO_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec2hit3hitPEPECO), __ELEC_PIPICO_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec3hit4hitPEPECO), __ELEC_PIPICO_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec4hit5hitPEPECO), __ELEC_PIPICO_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec5hit6hitPEPECO), __ELEC_PIPICO_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec6hit7hitPEPECO), __ELEC_PIPICO_TITLE_BIN_REGION__);
-  create2d(SAME_TITLE_WITH_VALNAME(h2_elec7hit8hitPEPECO), __ELEC_PIPICO_TITLE_BIN_REGION__);
+  if (isHistGroupOn(kElecEventHists)) {
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec1hitXFish), __ELEC_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec1hitYFish), __ELEC_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec1hitXY), __ELEC_XY_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec2hitXFish), __ELEC_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec2hitYFish), __ELEC_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec2hitXY), __ELEC_XY_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec3hitXFish), __ELEC_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec3hitYFish), __ELEC_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec3hitXY), __ELEC_XY_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec4hitXFish), __ELEC_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec4hitYFish), __ELEC_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec4hitXY), __ELEC_XY_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec5hitXFish), __ELEC_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec5hitYFish), __ELEC_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec5hitXY), __ELEC_XY_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec6hitXFish), __ELEC_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec6hitYFish), __ELEC_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec6hitXY), __ELEC_XY_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec7hitXFish), __ELEC_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec7hitYFish), __ELEC_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec7hitXY), __ELEC_XY_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec8hitXFish), __ELEC_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec8hitYFish), __ELEC_FISH_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec8hitXY), __ELEC_XY_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec1hit2hitPEPECO), __ELEC_PIPICO_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec2hit3hitPEPECO), __ELEC_PIPICO_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec3hit4hitPEPECO), __ELEC_PIPICO_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec4hit5hitPEPECO), __ELEC_PIPICO_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec5hit6hitPEPECO), __ELEC_PIPICO_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec6hit7hitPEPECO), __ELEC_PIPICO_TITLE_BIN_REGION__);
+    create2d(SAME_TITLE_WITH_VALNAME(h2_elec7hit8hitPEPECO), __ELEC_PIPICO_TITLE_BIN_REGION__);
+  }
 }
 void Analysis::SortRun::createC1() {
   closeC1();
+  if (!isHistGroupOn(kTimesumHists)) return;
   pC1 = createCanvas("ion_canvas", "ion_canvas", 10, 10, 910, 910);
   pC1->Divide(3, 3);
   pC1->cd(1);
@@ -280,6 +371,7 @@ void Analysis::SortRun::createC1() {
 }
 void Analysis::SortRun::createC2() {
   closeC2();
+  if (!isHistGroupOn(kTimesumHists)) return;
   pC1 = createCanvas("elec_canvas", "elec_canvas", 10, 10, 910, 910);
   pC1->Divide(3, 3);
   pC1->cd(1);
@@ -354,6 +446,7 @@ void Analysis::SortRun::closeC2() {
   }
 }
 void Analysis::SortRun::closeTree() {
+  stopTreeWriter();
   if (existTree()) {
     pRootTree->Write();
     delete pRootTree;
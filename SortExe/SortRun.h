@@ -7,6 +7,9 @@
 #include <fstream>
 #include <ctime>
 #include <math.h>
+#include <atomic>
+#include <thread>
+#include <vector>
 #include <TROOT.h>
 #include <TFile.h>
 #include <TTree.h>
@@ -47,6 +50,7 @@ struct Regions {
 };
 
 Regions<double> readBunchMaskRm(const Analysis::JSONReader &reader, const std::string prefix);
+std::vector<std::string> readDisabledHistGroups(const Analysis::JSONReader &reader, const std::string prefix, const int cmd);
 
 class SortRun: public Hist {
  private:
@@ -60,8 +64,24 @@ class SortRun: public Hist {
   bool isFileExist(const char *fileName);
   TCanvas *createCanvas(std::string name, std::string titel, int xposition, int yposition, int pixelsx, int pixelsy);
  public:
-  SortRun(const std::string pref, const int iNum, const int eNum);
+  SortRun(const std::string pref, const int iNum, const int eNum,
+          const bool deferHists = false, const std::vector<std::string> disabledHistGroups = {},
+          const bool writeTree = true, const int treeQueueSize = 0);
   ~SortRun();
+  const std::string getRootFilename() const;
+
+ public:
+  enum HistGroup {
+    kRawHists, // timestamp, TDC, bunch marker
+    kTimesumHists, // timesums and images of the sorters
+    kIonEventHists, // fish, XY, PIPICO
+    kElecEventHists, // fish, XY, PEPECO
+    numHistGroups
+  };
+  static HistGroup getHistGroup(const std::string name);
+  const bool isHistGroupOn(const HistGroup g) const;
+ private:
+  bool histGroupOn[numHistGroups];
 
 
  private:
@@ -84,11 +104,25 @@ class SortRun: public Hist {
   void createTree();
   void closeTree();
  public:
-  struct DataSet { double x, y, t; int flag; } *pIonDataSet, *pElecDataSet;
+  struct DataSet { double x, y, t; int flag; } *pIonDataSet = nullptr, *pElecDataSet = nullptr;
   void fillTree(const int ionHitNum, const DataSet *pIon,
                 const int elecHitNum, const DataSet *pElec);
  private:
   const DataSet dumpData = { NAN, NAN, NAN, -1 };
+  void copyToBranches(const int ionHitNum, const DataSet *pIon,
+                      const int elecHitNum, const DataSet *pElec);
+
+ private:
+  // async tree: fillTree copies the hits to a ring of events, a writer thread fills
+  // the tree, so the basket compression overlaps with sorting. one producer, one consumer
+  int treeQueueSize = 0; // 0=fill on the caller thread
+  std::vector<int> queuedIonNums, queuedElecNums;
+  std::vector<DataSet> queuedIons, queuedElecs; // treeQueueSize * max hits
+  std::atomic<long> queueHead, queueTail; // next event to push, next event to fill
+  std::atomic<bool> isWriterStopping;
+  std::thread treeWriter;
+  void runTreeWriter();
+  void stopTreeWriter();
 
  private:
   void createHists();
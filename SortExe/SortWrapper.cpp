@@ -3,6 +3,11 @@
 //
 
 #include "SortWrapper.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <sys/stat.h>
+
 void readline_from_config_file(FILE *ffile, char *text, __int32 max_len) {
   int i;
   text[0] = 0;
@@ -164,8 +169,200 @@ bool create_calibration_tables(const char *filename, sort_class *sorter) {
   fclose(fo);
   return true;
 }
+uint64_t calibration_table_checksum(const char *data, size_t size) {
+  uint64_t h = 14695981039346656037ull;
+  for (size_t i = 0; i < size; ++i) {
+    h ^= (unsigned char) data[i];
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+bool is_binary_calibration_table(const char *filename) {
+  if (!filename) return false;
+  FILE *fi = fopen(filename, "rb");
+  if (!fi) return false;
+  char magic[sizeof(CALIB_TAB_MAGIC)] = {0};
+  const bool b = fread(magic, sizeof(magic), 1, fi) == 1
+      && std::memcmp(magic, CALIB_TAB_MAGIC, sizeof(magic)) == 0;
+  fclose(fi);
+  return b;
+}
+// the 6 tables of a file as x0, y0, x1, y1, ...
+static bool read_binary_calibration_points(const char *filename, std::vector<double> *tabs) {
+  if (!filename) return false;
+
+  // read the whole file at once
+  FILE *fi = fopen(filename, "rb");
+  if (!fi) return false;
+  std::vector<char> buf;
+  {
+    char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), fi)) > 0) buf.insert(buf.end(), chunk, chunk + n);
+  }
+  fclose(fi);
+
+  // header: magic, version, number of tables; footer: checksum
+  const size_t headerSize = sizeof(CALIB_TAB_MAGIC) + 2 * sizeof(uint32_t);
+  if (buf.size() < headerSize + sizeof(uint64_t)) return false;
+  if (std::memcmp(&buf[0], CALIB_TAB_MAGIC, sizeof(CALIB_TAB_MAGIC)) != 0) return false;
+  const size_t payloadSize = buf.size() - sizeof(uint64_t);
+  uint64_t checksum;
+  std::memcpy(&checksum, &buf[payloadSize], sizeof(checksum));
+  if (checksum != calibration_table_checksum(&buf[0], payloadSize)) {
+    printf("Error: the checksum of the calibration table does not match.\n");
+    return false;
+  }
+  size_t pos = sizeof(CALIB_TAB_MAGIC);
+  uint32_t version, numTabs;
+  std::memcpy(&version, &buf[pos], sizeof(version));
+  pos += sizeof(version);
+  std::memcpy(&numTabs, &buf[pos], sizeof(numTabs));
+  pos += sizeof(numTabs);
+  if (version != CALIB_TAB_VERSION) {
+    printf("Error: unknown version %u of the calibration table.\n", version);
+    return false;
+  }
+  if (numTabs != NUM_CALIB_TABS) return false;
+
+  for (uint32_t i = 0; i < numTabs; ++i) {
+    uint32_t points;
+    if (pos + sizeof(points) > payloadSize) return false;
+    std::memcpy(&points, &buf[pos], sizeof(points));
+    pos += sizeof(points);
+    if ((payloadSize - pos) / (2 * sizeof(double)) < points) return false;
+    tabs[i].resize(2 * points);
+    if (points > 0) std::memcpy(&tabs[i][0], &buf[pos], 2 * points * sizeof(double));
+    pos += 2 * points * sizeof(double);
+  }
+  return pos == payloadSize;
+}
+static bool write_binary_calibration_points(const char *filename, const std::vector<double> *tabs) {
+  if (!filename) return false;
+  std::vector<char> buf;
+  auto append = [&buf](const void *p, size_t n) {
+    buf.insert(buf.end(), (const char *) p, (const char *) p + n);
+  };
+  const uint32_t version = CALIB_TAB_VERSION, numTabs = NUM_CALIB_TABS;
+  append(CALIB_TAB_MAGIC, sizeof(CALIB_TAB_MAGIC));
+  append(&version, sizeof(version));
+  append(&numTabs, sizeof(numTabs));
+  for (int i = 0; i < NUM_CALIB_TABS; ++i) {
+    const uint32_t points = (uint32_t) (tabs[i].size() / 2);
+    append(&points, sizeof(points));
+    if (points > 0) append(&tabs[i][0], 2 * points * sizeof(double));
+  }
+  const uint64_t checksum = calibration_table_checksum(&buf[0], buf.size());
+  append(&checksum, sizeof(checksum));
+
+  FILE *fo = fopen(filename, "wb");
+  if (!fo) return false;
+  const bool b = fwrite(&buf[0], buf.size(), 1, fo) == 1;
+  fclose(fo);
+  return b;
+}
+// the text tables have the w layer only for hexanodes, in the order of read_calibration_tables
+static bool read_text_calibration_points(const char *filename, const bool use_HEX, std::vector<double> *tabs) {
+  if (!filename) return false;
+  FILE *fi = fopen(filename, "rt");
+  if (!fi) return false;
+  for (int i = 0; i < NUM_CALIB_TABS; ++i) {
+    tabs[i].clear();
+    if (i % 3 == 2 && !use_HEX) continue;
+    const int points = read_int(fi);
+    for (int j = 0; j < points; ++j) {
+      tabs[i].push_back(read_double(fi));
+      tabs[i].push_back(read_double(fi));
+    }
+  }
+  const bool b = !ferror(fi);
+  fclose(fi);
+  return b;
+}
+static bool write_text_calibration_points(const char *filename, const bool use_HEX, const std::vector<double> *tabs) {
+  if (!filename) return false;
+  FILE *fo = fopen(filename, "wt");
+  if (!fo) return false;
+  const char *labels[NUM_CALIB_TABS] = {
+      "number of sum calibration points for layer U",
+      "number of sum calibration points for layer V",
+      "number of sum calibration points for layer W (only needed for HEX-detectors)",
+      "number of pos-calibration points for layer U",
+      "number of pos-calibration points for layer V",
+      "number of pos-calibration points for layer W (only needed for HEX-detectors)"};
+  for (int i = 0; i < NUM_CALIB_TABS; ++i) {
+    const int points = (int) (tabs[i].size() / 2);
+    fprintf(fo, "\n\n%i  	// %s\n", points, labels[i]);
+    if (i % 3 == 2 && !use_HEX) continue;
+    for (int j = 0; j < points; ++j) fprintf(fo, "%lg  %lg\n", tabs[i][2 * j], tabs[i][2 * j + 1]);
+  }
+  return fclose(fo) == 0;
+}
+bool read_binary_calibration_tables(const char *filename, sort_class *sorter) {
+  if (!sorter) return false;
+  std::vector<double> tabs[NUM_CALIB_TABS];
+  if (!read_binary_calibration_points(filename, tabs)) return false;
+
+  interpolate_class *correctors[NUM_CALIB_TABS] = {nullptr};
+  if (sorter->use_sum_correction) {
+    correctors[0] = sorter->signal_corrector->sum_corrector_U;
+    correctors[1] = sorter->signal_corrector->sum_corrector_V;
+    if (sorter->use_HEX) correctors[2] = sorter->signal_corrector->sum_corrector_W;
+  }
+  if (sorter->use_pos_correction) {
+    correctors[3] = sorter->signal_corrector->pos_corrector_U;
+    correctors[4] = sorter->signal_corrector->pos_corrector_V;
+    if (sorter->use_HEX) correctors[5] = sorter->signal_corrector->pos_corrector_W;
+  }
+  for (int i = 0; i < NUM_CALIB_TABS; ++i) {
+    if (!correctors[i]) continue;
+    for (size_t j = 0; j + 1 < tabs[i].size(); j += 2) correctors[i]->set_point(tabs[i][j], tabs[i][j + 1]);
+  }
+  return true;
+}
+bool create_binary_calibration_tables(const char *filename, sort_class *sorter) {
+  if (!sorter) return false;
+  if (!filename) return false;
+  sorter->do_calibration();
+
+  std::vector<double> tabs[NUM_CALIB_TABS];
+  const int layers[NUM_CALIB_TABS] = {0, 1, 2, 0, 1, 2}; // 0 = u, 1 = v, 2 = w
+  for (int i = 0; i < NUM_CALIB_TABS; ++i) {
+    const bool isSum = i < 3;
+    int points = 0;
+    if (layers[i] < 2 || sorter->use_HEX) {
+      if (isSum) {
+        const profile_class *profiles[3] = {sorter->sum_walk_calibrator->sumu_profile,
+                                            sorter->sum_walk_calibrator->sumv_profile,
+                                            sorter->sum_walk_calibrator->sumw_profile};
+        points = profiles[layers[i]]->number_of_columns;
+      } else {
+        points = sorter->pos_walk_calibrator->number_of_columns;
+      }
+    }
+    for (int binx = 0; binx < points; ++binx) {
+      double x, y;
+      if (isSum) sorter->sum_walk_calibrator->get_correction_point(x, y, binx, layers[i]);
+      else sorter->pos_walk_calibrator->get_correction_point(x, y, binx, layers[i]);
+      tabs[i].push_back(x);
+      tabs[i].push_back(y);
+    }
+  }
+  return write_binary_calibration_points(filename, tabs);
+}
+bool convert_calibration_tables(const char *src, const char *dst, const bool use_HEX) {
+  std::vector<double> tabs[NUM_CALIB_TABS];
+  if (is_binary_calibration_table(src)) {
+    return read_binary_calibration_points(src, tabs) && write_text_calibration_points(dst, use_HEX, tabs);
+  }
+  return read_text_calibration_points(src, use_HEX, tabs) && write_binary_calibration_points(dst, tabs);
+}
 Analysis::SortWrapper::~SortWrapper() {
   pLMFSource = nullptr;
+  if (pCalibWorker != nullptr) {
+    delete pCalibWorker;
+    pCalibWorker = nullptr;
+  }
   if (pSorter != nullptr) {
     delete pSorter;
     pSorter = nullptr;
@@ -185,6 +382,13 @@ bool Analysis::SortWrapper::readConfig(const Analysis::JSONReader &reader, const
     return false;
   }
   calibTabFilename = reader.get<const char *>(prefix + ".calibration_table");
+  {
+    const auto format = reader.getOpt<const char *>(prefix + ".calibration_table_format");
+    const std::string str = format ? *format : "text";
+    if (str == "binary") isCalibTabBinary = true;
+    else if (str == "text") isCalibTabBinary = false;
+    else throw std::invalid_argument("Unknown calibration table format!");
+  }
 
   std::map<std::string, int> chMap;
   chMap = reader.getMap<int>(prefix + ".channel_map");
@@ -220,6 +424,14 @@ bool Analysis::SortWrapper::readConfig(const Analysis::JSONReader &reader, const
   pSorter->dead_time_mcp = reader.getDoubleAt(prefix + ".MCP_deadtime");
   pSorter->use_sum_correction = reader.getBoolAt(prefix + ".correct_timesum");
   pSorter->use_pos_correction = reader.getBoolAt(prefix + ".correct_position");
+  isUsingCalibWorker = reader.getBoolAtIfItIs(prefix + ".calibration_worker", false);
+  {
+    const auto pMCP = reader.getOpt<int>(prefix + ".pre_sort_filter.minimum_MCP_hits");
+    const auto pAnode = reader.getOpt<int>(prefix + ".pre_sort_filter.minimum_anode_hits");
+    minNumOfMCPHits = pMCP ? *pMCP : 0;
+    minNumOfAnodeHits = pAnode ? *pAnode : 0;
+    if (minNumOfMCPHits < 0 || minNumOfAnodeHits < 0) throw std::invalid_argument("The pre-sort filter is invalid!");
+  }
   return true;
 }
 bool Analysis::SortWrapper::init() {
@@ -237,6 +449,9 @@ bool Analysis::SortWrapper::init() {
           pSorter->fu, pSorter->fv, pSorter->fw // fu, fv, fw
       );
     }
+    if (cmd >= kCalib && isUsingCalibWorker) {
+      pCalibWorker = new CalibWorker(pSorter, NUM_CHANNELS, NUM_IONS, factors["fw_offset"]);
+    }
     int error_code = pSorter->init_after_setting_parameters();
     if (error_code) {
       std::cout << "ion sorter could not be initialized" << std::endl;
@@ -245,6 +460,7 @@ bool Analysis::SortWrapper::init() {
       printf("Error %i: %s\n", error_code, error_text);
       return false;
     }
+    if (!registerChannels()) std::cout << "the shifts are not constant, they are applied by the sorter... ";
     std::cout << "ok" << std::endl;
     return true;
 }
@@ -257,42 +473,47 @@ Analysis::SortWrapper::SortWrapper(Analysis::LMFWrapper *p) {
   t0 = 0;
   factors.clear();
   calibTabFilename = "";
+  isCalibTabBinary = false;
+  isShiftedBySorter = true;
   numHits = 0;
+  isUsingCalibWorker = false;
+  pCalibWorker = nullptr;
+  minNumOfMCPHits = 0;
+  minNumOfAnodeHits = 0;
 }
 bool Analysis::SortWrapper::isNull() const {
   return pSorter == nullptr;
 }
 bool Analysis::SortWrapper::convertTDC() {
   if (pSorter == nullptr) return true;
+  const double &fw_offset = factors["fw_offset"];
+  const auto &count = pLMFSource->count;
+  auto &tdc_ns = pLMFSource->TDCns;
+  // the channels are already converted and shifted by LMFWrapper::convertTDC
+  if (pChT0 != nullptr) t0 = count[*pChT0] > 0 ? double(pLMFSource->getTDC(*pChT0)[0]) * pLMFSource->TDCRes : 0;
+  if (isShiftedBySorter) shift();
+  // for calibration of fv, fw, w_offset and correction tables
+  if (cmd < kCalib) return true;
+  if (pCalibWorker != nullptr) {
+    pCalibWorker->push(count, &tdc_ns[0][0]);
+  } else {
+    pSorter->feed_calibration_data(true, fw_offset);
+  }
+  return true;
+}
+void Analysis::SortWrapper::finishCalibWorker() {
+  if (pCalibWorker == nullptr) return;
+  std::cout << "Waiting for the calibration worker... ";
+  pCalibWorker->drain();
+  std::cout << "ok" << std::endl;
+}
+void Analysis::SortWrapper::shift() {
   const double &offset_u = factors["offset_u"];
   const double &offset_v = factors["offset_v"];
   const double &offset_w = factors["offset_w"];
   const double &fw_offset = factors["fw_offset"];
   const double &offset_x = factors["offset_x"];
   const double &offset_y = factors["offset_y"];
-  const double &Res = pLMFSource->TDCRes;
-  const auto &count = pLMFSource->count;
-  const auto &TDC = pLMFSource->TDC;
-  auto &tdc_ns = pLMFSource->TDCns;
-  if (pSorter->Cmcp > -1) {
-    for (unsigned int i = 0; i < count[pSorter->Cmcp]; ++i)
-      tdc_ns[pSorter->Cmcp][i] = double(TDC[pSorter->Cmcp][i]) * Res;
-  }
-  for (unsigned int i = 0; i < count[pSorter->Cu1]; ++i)
-    tdc_ns[pSorter->Cu1][i] = double(TDC[pSorter->Cu1][i]) * Res;
-  for (unsigned int i = 0; i < count[pSorter->Cu2]; ++i)
-    tdc_ns[pSorter->Cu2][i] = double(TDC[pSorter->Cu2][i]) * Res;
-  for (unsigned int i = 0; i < count[pSorter->Cv1]; ++i)
-    tdc_ns[pSorter->Cv1][i] = double(TDC[pSorter->Cv1][i]) * Res;
-  for (unsigned int i = 0; i < count[pSorter->Cv2]; ++i)
-    tdc_ns[pSorter->Cv2][i] = double(TDC[pSorter->Cv2][i]) * Res;
-  if (pSorter->use_HEX) {
-    for (unsigned int i = 0; i < count[pSorter->Cw1]; ++i)
-      tdc_ns[pSorter->Cw1][i] = double(TDC[pSorter->Cw1][i]) * Res;
-    for (unsigned int i = 0; i < count[pSorter->Cw2]; ++i)
-      tdc_ns[pSorter->Cw2][i] = double(TDC[pSorter->Cw2][i]) * Res;
-  }
-  if (pChT0 != nullptr) t0 = double(TDC[*pChT0][0]) * Res;
   if (pSorter->use_HEX) {
     // shift the time sums to zero:
     pSorter->shift_sums(+1, offset_u, offset_v, offset_w);
@@ -304,11 +525,40 @@ bool Analysis::SortWrapper::convertTDC() {
   }
   // shift all signals from the anode so that the center of the detector is at x=y=0:
   pSorter->shift_position_origin(+1, offset_x, offset_y);
-  // for calibration of fv, fw, w_offset and correction tables
-  pSorter->feed_calibration_data(true, fw_offset);
-  return true;
+}
+bool Analysis::SortWrapper::registerChannels() {
+  std::vector<int> chs = {pSorter->Cu1, pSorter->Cu2, pSorter->Cv1, pSorter->Cv2};
+  if (pSorter->use_HEX) {
+    chs.push_back(pSorter->Cw1);
+    chs.push_back(pSorter->Cw2);
+  }
+  if (pSorter->Cmcp > -1) chs.push_back(pSorter->Cmcp);
+
+  // the shifts of the sorter are constant offsets per channel, so they are
+  // measured with two probe hits and applied during the conversion
+  auto &count = pLMFSource->count;
+  auto &tdc_ns = pLMFSource->TDCns;
+  std::map<int, double> shifts;
+  isShiftedBySorter = false;
+  for (const double probe: {0.0, 1000.0}) {
+    for (const int ch: chs) {
+      count[ch] = 1;
+      tdc_ns[ch][0] = probe;
+    }
+    shift();
+    for (const int ch: chs) {
+      const double d = tdc_ns[ch][0] - probe;
+      if (shifts.find(ch) == shifts.end()) shifts[ch] = d;
+      else if (std::fabs(shifts[ch] - d) > 1e-9) isShiftedBySorter = true;
+    }
+  }
+  for (const int ch: chs) count[ch] = 0;
+  for (const int ch: chs) pLMFSource->addConvChannel(ch, isShiftedBySorter ? 0 : shifts[ch]);
+  if (pChT0 != nullptr) pLMFSource->addRawChannel(*pChT0);
+  return !isShiftedBySorter;
 }
 bool Analysis::SortWrapper::isFull() const {
+  if (pCalibWorker != nullptr) return pCalibWorker->isFull();
   if (cmd >= kCalib && pSorter->scalefactors_calibrator != nullptr)
     if (pSorter->scalefactors_calibrator->map_is_full_enough())
       return true;
@@ -318,8 +568,11 @@ bool Analysis::SortWrapper::readCalibTab() {
   if (pSorter == nullptr) return true;
   if (pSorter->use_sum_correction || pSorter->use_pos_correction) {
     std::cout << "Reading calibration table: " << calibTabFilename << "... ";
-    const bool b = read_calibration_tables(calibTabFilename.c_str(), pSorter);
-    std::cout << "ok" << std::endl;
+    // the format is detected from the file, text tables stay readable
+    const bool b = is_binary_calibration_table(calibTabFilename.c_str())
+                   ? read_binary_calibration_tables(calibTabFilename.c_str(), pSorter)
+                   : read_calibration_tables(calibTabFilename.c_str(), pSorter);
+    std::cout << (b ? "ok" : "failed") << std::endl;
     return b;
   }
   return true;
@@ -328,8 +581,11 @@ bool Analysis::SortWrapper::genClibTab() const {
     if (pSorter == nullptr) return true;
     if (cmd == kGenCalibTab) {
       std::cout << "Generating calibration table: " << calibTabFilename << "... ";
-      const bool result = create_calibration_tables(calibTabFilename.c_str(), pSorter);
-      std::cout << "ok" << std::endl;
+      sort_class *pCalibrated = pCalibWorker != nullptr ? pCalibWorker->getSorter() : pSorter;
+      const bool result = isCalibTabBinary
+                          ? create_binary_calibration_tables(calibTabFilename.c_str(), pCalibrated)
+                          : create_calibration_tables(calibTabFilename.c_str(), pCalibrated);
+      std::cout << (result ? "ok" : "failed") << std::endl;
       return result;
     }
     return false;
@@ -338,14 +594,15 @@ bool Analysis::SortWrapper::calibFactors() const {
     if (pSorter == nullptr) return true;
     if (cmd == kCalib) {
       std::cout << "Calibrating... ";
-      const bool b = pSorter->do_calibration();
+      sort_class *pCalibrated = pCalibWorker != nullptr ? pCalibWorker->getSorter() : pSorter;
+      const bool b = pCalibrated->do_calibration();
       std::cout << "ok" << std::endl;
-      if (pSorter->scalefactors_calibrator) {
+      if (pCalibrated->scalefactors_calibrator) {
         printf("Good scalefactors are:\nf_U = %lg\nf_V = %lg\nf_W = %lg\nOffset on layer W = %lg\n",
-               2. * pSorter->fu,
-               2. * pSorter->scalefactors_calibrator->best_fv,
-               2. * pSorter->scalefactors_calibrator->best_fw,
-               pSorter->scalefactors_calibrator->best_w_offset);
+               2. * pCalibrated->fu,
+               2. * pCalibrated->scalefactors_calibrator->best_fv,
+               2. * pCalibrated->scalefactors_calibrator->best_fw,
+               pCalibrated->scalefactors_calibrator->best_w_offset);
       }
       return b;
     }
@@ -454,6 +711,25 @@ bool Analysis::SortWrapper::sort() {
 int Analysis::SortWrapper::getNumHits() const {
   return numHits;
 }
+int Analysis::SortWrapper::getNumOfAnodeHits() const {
+  if (pSorter == nullptr) return 0;
+  // a position needs two layers and a layer is limited by its less hit end, so the second most
+  // hit layer is the number of positions found without reconstructing missing signals
+  const auto &count = pLMFSource->count;
+  int n[3];
+  n[0] = (int) std::min(count[pSorter->Cu1], count[pSorter->Cu2]);
+  n[1] = (int) std::min(count[pSorter->Cv1], count[pSorter->Cv2]);
+  n[2] = pSorter->use_HEX ? (int) std::min(count[pSorter->Cw1], count[pSorter->Cw2]) : 0;
+  std::sort(n, n + 3);
+  return n[1];
+}
+bool Analysis::SortWrapper::isPassingPreSortFilter() const {
+  if (pSorter == nullptr) return true;
+  const auto &count = pLMFSource->count;
+  if (minNumOfMCPHits > 0 && pSorter->use_MCP && (int) count[pSorter->Cmcp] < minNumOfMCPHits) return false;
+  if (minNumOfAnodeHits > 0 && getNumOfAnodeHits() < minNumOfAnodeHits) return false;
+  return true;
+}
 hit_class **Analysis::SortWrapper::getOutputArr() const {
   return pSorter->output_hit_array;
 }
@@ -485,35 +761,201 @@ bool Analysis::LMFWrapper::readConfig(const Analysis::JSONReader &reader) {
     auto pStr = reader.getOpt<const char *>("LMF_files");
     if (pStr) {
       filenames.push_back(std::string(*pStr));
-      return true;
     } else {
       auto pArr = reader.getOptArr<const char *>("LMF_files");
       if (!pArr) return false;
       for (auto str: *pArr) filenames.push_back(std::string(str));
-      return true;
     }
+    isFollowing = reader.getBoolAtIfItIs("follow_LMF", false);
+    const auto pInterval = reader.getOpt<double>("follow_interval");
+    if (pInterval) followInterval = *pInterval;
+    const auto pTimeout = reader.getOpt<double>("follow_timeout");
+    if (pTimeout) followTimeout = *pTimeout;
+    if (followInterval <= 0) throw std::invalid_argument("The follow interval is invalid!");
+    const auto pRange = reader.getOptArr<double>("event_range");
+    if (pRange) {
+      if (pRange->size() != 2 || (*pRange)[0] < 0 || (*pRange)[1] < 0
+          || ((*pRange)[1] > 0 && (*pRange)[1] <= (*pRange)[0]))
+        throw std::invalid_argument("The event range is invalid!");
+      firstEvent = (unsigned __int64) (*pRange)[0];
+      lastEvent = (unsigned __int64) (*pRange)[1];
+    }
+    isKeepingCheckpoints = reader.getBoolAtIfItIs("keep_LMF_checkpoints", false);
+    isUsingHitCache = reader.getBoolAtIfItIs("hit_cache", false);
+    return true;
 }
 bool Analysis::LMFWrapper::readFile(const int i) {
+    currentFile = i;
+    idleTime = 0;
+    // a file which is still written is never cached
+    const bool isCaching = isUsingHitCache && !isFollowing;
+    if (isCaching && openHitCache()) return true;
     pLMF = new LMF_IO(NUM_CHANNELS, NUM_IONS);
     bool b;
     b = pLMF->OpenInputLMF(filenames[i]);
-    if (b) {
-      std::cout << "A LMF file " << filenames[i] << " is open for reading!" << std::endl;
-      return true;
-    } else {
+    if (!b) {
       std::cout << "Could not open LMF file: " << filenames[i] << std::endl;
       return false;
     }
+    std::cout << "A LMF file " << filenames[i] << " is open for reading!" << std::endl;
+    numLoadedCheckpoints = 0;
+    if (isKeepingCheckpoints && pLMF->LoadCheckpoints(getCheckpointFilename()))
+      numLoadedCheckpoints = pLMF->GetNumberOfCheckpoints();
+    if (firstEvent > 0) {
+      if (!pLMF->SeekToEventNumber(firstEvent)) {
+        std::cout << "Could not seek to the event " << firstEvent << ": "
+                  << pLMF->GetErrorText(pLMF->GetErrorStatus()) << std::endl;
+        return false;
+      }
+      std::cout << "Starting at the event " << firstEvent << std::endl;
+    }
+    struct stat st;
+    if (isCaching && firstEvent == 0 && lastEvent == 0 && stat(filenames[i].c_str(), &st) == 0) {
+      pCacheWriter = new HitCacheWriter(getHitCacheFilename(), getCachedChannels(), NUM_IONS, (uint64_t) st.st_size,
+                                        (int64_t) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec);
+      if (pCacheWriter->isOpen()) {
+        std::cout << "The hits are cached to " << getHitCacheFilename() << std::endl;
+      } else {
+        delete pCacheWriter;
+        pCacheWriter = nullptr;
+      }
+    }
+    return true;
+}
+bool Analysis::LMFWrapper::openHitCache() {
+  struct stat st;
+  if (stat(filenames[currentFile].c_str(), &st) != 0) return false;
+  pCacheReader = new HitCacheReader(getHitCacheFilename());
+  const auto mtime = (int64_t) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+  if (!pCacheReader->isMatching((uint64_t) st.st_size, mtime, getCachedChannels())) {
+    // written for another LMF file or other channels, it is written again
+    delete pCacheReader;
+    pCacheReader = nullptr;
+    return false;
+  }
+  while (pCacheReader->getEventNumber() < firstEvent) {
+    if (!pCacheReader->skip()) break;
+  }
+  std::cout << "The hits of " << filenames[currentFile] << " are read from " << getHitCacheFilename() << std::endl;
+  return true;
+}
+std::string Analysis::LMFWrapper::getHitCacheFilename() const {
+  return filenames[currentFile] + ".hits";
+}
+void Analysis::LMFWrapper::addRawChannel(const int ch) {
+  if (ch < 0 || ch >= NUM_CHANNELS) return;
+  if (std::find(rawChs.begin(), rawChs.end(), ch) == rawChs.end()) rawChs.push_back(ch);
+}
+std::vector<int> Analysis::LMFWrapper::getCachedChannels() const {
+  std::vector<int> chs = convChs;
+  for (const int ch : rawChs) {
+    if (std::find(chs.begin(), chs.end(), ch) == chs.end()) chs.push_back(ch);
+  }
+  std::sort(chs.begin(), chs.end());
+  return chs;
+}
+std::string Analysis::LMFWrapper::getCheckpointFilename() const {
+  return filenames[currentFile] + ".ckpt";
 }
 bool Analysis::LMFWrapper::readNextEvent() {
+  if (pCacheReader) {
+    memset(count, 0, sizeof(count));
+    if (lastEvent > 0 && pCacheReader->getEventNumber() >= lastEvent) return false;
+    if (!pCacheReader->next(timestamp, count, &TDC[0][0], NUM_IONS)) return false;
+    pTDC = &TDC[0][0];
+    return true;
+  }
   memset(count, 0, pLMF->number_of_channels * sizeof(int));
+  if (lastEvent > 0 && pLMF->GetEventNumber() >= lastEvent) return false;
+  // in follow mode an incomplete event is read again from eventStart when the file has grown,
+  // until then the reads fail at the EOF and keep eventStart. The event counter and the TDC8HP
+  // state are rewound with the position, ReadNextEvent counts the event before its body is read.
+  if (!pLMF->input_lmf->eof) pLMF->GetReaderState(eventStart, eventStartNumber);
   if (!pLMF->ReadNextEvent()) return false;
+  idleTime = 0;
   pLMF->GetNumberOfHitsArray(count);
-  pLMF->GetTDCDataArray((int *) TDC);
+  pTDC = pLMF->GetTDCDataPointer();
+  if (pTDC == nullptr) {
+    pLMF->GetTDCDataArraySparse((int *) TDC);
+    pTDC = &TDC[0][0];
+  }
   timestamp = pLMF->GetDoubleTimeStamp(); // absolute timestamp in seconds
+  if (pCacheWriter) pCacheWriter->write(timestamp, count, pTDC, NUM_IONS);
   return true;
 }
+unsigned __int64 Analysis::LMFWrapper::getEventNumber() const {
+  if (pCacheReader) return pCacheReader->getEventNumber();
+  return pLMF->GetEventNumber();
+}
+unsigned __int64 Analysis::LMFWrapper::getNumberOfEvents() const {
+  if (pCacheReader) return pCacheReader->getNumberOfEvents();
+  return pLMF->uint64_Numberofevents;
+}
+unsigned __int64 Analysis::LMFWrapper::getBytePosition() const {
+  if (pCacheReader) return pCacheReader->getPosition();
+  return pLMF->input_lmf->tell();
+}
+bool Analysis::LMFWrapper::isWaitingForData() const {
+  // only the last file can still be written
+  if (!isFollowing || currentFile != (int) filenames.size() - 1) return false;
+  return pLMF != nullptr && pLMF->input_lmf != nullptr && pLMF->input_lmf->eof;
+}
+Analysis::LMFWrapper::FollowState Analysis::LMFWrapper::waitForData() {
+  if (idleTime >= followTimeout) return kTimeout;
+  std::this_thread::sleep_for(std::chrono::duration<double>(followInterval));
+  idleTime += followInterval;
+  struct stat st;
+  if (stat(filenames[currentFile].c_str(), &st) != 0) return kWaiting;
+  const auto size = (unsigned __int64) st.st_size;
+  auto &file = *pLMF->input_lmf;
+  if (size <= file.filesize) return kWaiting;
+  file.filesize = size;
+  pLMF->SetReaderState(eventStart, eventStartNumber);
+  return kGrown;
+}
+void Analysis::LMFWrapper::addConvChannel(const int ch, const double shift) {
+  for (size_t k = 0; k < convChs.size(); ++k) {
+    if (convChs[k] != ch) continue;
+    if (convShifts[k] != shift) throw std::invalid_argument("The channel is shifted by two detectors!");
+    return;
+  }
+  convChs.push_back(ch);
+  convShifts.push_back(shift);
+}
+void Analysis::LMFWrapper::convertTDC() {
+  // one pass over the mapped channels of both detectors,
+  // the inner loop is a multiply-add the compiler vectorizes
+  const double res = TDCRes;
+  for (size_t k = 0; k < convChs.size(); ++k) {
+    const int ch = convChs[k];
+    const int n = count[ch];
+    const double shift = convShifts[k];
+    const int *__restrict in = getTDC(ch);
+    double *__restrict out = TDCns[ch];
+    for (int i = 0; i < n; ++i) out[i] = double(in[i]) * res + shift;
+  }
+}
+void Analysis::LMFWrapper::shareEvent(const Analysis::LMFWrapper &source) {
+  memcpy(count, source.count, sizeof(count));
+  pTDC = source.pTDC;
+  timestamp = source.timestamp;
+}
 void Analysis::LMFWrapper::cleanup() {
+  if (pCacheWriter) {
+    // only a cache of the whole file is kept
+    const bool isComplete = pLMF != nullptr && pLMF->GetErrorStatus() == 18;
+    if (isComplete && !pCacheWriter->finish()) std::cout << "Could not write " << getHitCacheFilename() << std::endl;
+    delete pCacheWriter;
+    pCacheWriter = nullptr;
+  }
+  if (pCacheReader) {
+    delete pCacheReader;
+    pCacheReader = nullptr;
+  }
+  if (pLMF && isKeepingCheckpoints && pLMF->GetNumberOfCheckpoints() > numLoadedCheckpoints) {
+    if (!pLMF->SaveCheckpoints(getCheckpointFilename()))
+      std::cout << "Could not write " << getCheckpointFilename() << std::endl;
+  }
   if (pLMF) {
     delete pLMF;
     pLMF = nullptr;
@@ -10,8 +10,13 @@
 #include <cmath>
 #include <termios.h>
 #include <map>
+#include <vector>
+#include <cstdint>
+#include <cstring>
 #include "resort64c.h"
 #include "LMF_IO.h"
+#include "CalibWorker.h"
+#include "HitCache.h"
 #include "../Core/JSONReader.h"
 
 #define NUM_IONS 200
@@ -23,18 +28,73 @@ double read_double(FILE *ffile);
 bool read_calibration_tables(const char *filename, sort_class *sorter);
 bool create_calibration_tables(const char *filename, sort_class *sorter);
 
+// binary calibration tables: header, 6 tables of (x, y) points and a FNV-1a checksum
+// tables: sum U, V, W and pos U, V, W
+#define CALIB_TAB_MAGIC "SP8CTAB"
+#define CALIB_TAB_VERSION 1
+#define NUM_CALIB_TABS 6
+uint64_t calibration_table_checksum(const char *data, size_t size);
+bool is_binary_calibration_table(const char *filename);
+bool read_binary_calibration_tables(const char *filename, sort_class *sorter);
+bool create_binary_calibration_tables(const char *filename, sort_class *sorter);
+// writes the table of src in the other format, the text tables have the w layer only for hexanodes
+bool convert_calibration_tables(const char *src, const char *dst, const bool use_HEX);
+
 namespace Analysis {
 struct LMFWrapper {
-  LMF_IO *pLMF;
+  LMF_IO *pLMF = nullptr;
   std::vector<std::string> filenames;
   const double TDCRes = 0.025; // 25ps tdc bin size
   double timestamp;
-  int TDC[NUM_CHANNELS][NUM_IONS];
+  int TDC[NUM_CHANNELS][NUM_IONS]; // only used if the LMF data can not be viewed
+  const int *pTDC; // TDC data of the current event, NUM_IONS slots per channel
   double TDCns[NUM_CHANNELS][NUM_IONS];
   unsigned int count[NUM_CHANNELS];
+  // only the first count[ch] hits of a channel are valid
+  const int *getTDC(const int ch) const { return pTDC + ch * NUM_IONS; }
   bool readConfig(const JSONReader &reader);
   bool readFile(const int i);
   bool readNextEvent();
+  // progress of the current file, from the LMF file or the hit cache
+  unsigned __int64 getEventNumber() const;
+  unsigned __int64 getNumberOfEvents() const; // 0=unknown
+  unsigned __int64 getBytePosition() const;
+  // follow mode: the last LMF file may still be written by the DAQ, at its end
+  // readNextEvent returns false and waitForData is polled until the file grows
+  enum FollowState { kGrown, kWaiting, kTimeout };
+  bool isFollowing = false;
+  double followInterval = 1; // [s]
+  double followTimeout = 600; // [s] without growth
+  int currentFile = -1;
+  LMF_checkpoint eventStart; // reader state before the incomplete event
+  unsigned __int64 eventStartNumber = 0; // events read before it
+  double idleTime = 0; // [s]
+  bool isWaitingForData() const;
+  FollowState waitForData();
+  // [firstEvent, lastEvent) of each LMF file, lastEvent=0 reads to the end. The TDC8HP files
+  // have no fixed event size, LMF_IO seeks from the checkpoints taken while the file is read.
+  unsigned __int64 firstEvent = 0;
+  unsigned __int64 lastEvent = 0;
+  // the checkpoints of a file are kept in FILE.ckpt, so the next run starts mid-file without a scan
+  bool isKeepingCheckpoints = false;
+  unsigned __int64 numLoadedCheckpoints = 0;
+  std::string getCheckpointFilename() const;
+  std::vector<int> convChs;
+  std::vector<double> convShifts; // [ns] added after the conversion
+  void addConvChannel(const int ch, const double shift);
+  // hit cache: the first pass over a whole LMF file keeps the hits of the channels the sorters
+  // read in FILE.hits, the next runs read them from the mapped cache instead of the LMF file
+  bool isUsingHitCache = false;
+  std::vector<int> rawChs; // read but not converted, the t0 and the bunch marker
+  void addRawChannel(const int ch);
+  std::vector<int> getCachedChannels() const;
+  HitCacheWriter *pCacheWriter = nullptr;
+  HitCacheReader *pCacheReader = nullptr;
+  bool openHitCache();
+  std::string getHitCacheFilename() const;
+  void convertTDC();
+  // the decoded event of another wrapper, which reads the file, converted with the shifts of the own sorters
+  void shareEvent(const LMFWrapper &source);
   void cleanup();
 };
 
@@ -61,7 +121,15 @@ class SortWrapper {
   double t0;
   std::map<std::string, double> factors;
   std::string calibTabFilename;
+  bool isCalibTabBinary;
+  bool isShiftedBySorter;
   int numHits;
+  bool isUsingCalibWorker;
+  CalibWorker *pCalibWorker;
+  int minNumOfMCPHits;
+  int minNumOfAnodeHits;
+  void shift();
+  bool registerChannels();
  public:
   SortWrapper(LMFWrapper *p);
   ~SortWrapper();
@@ -70,6 +138,9 @@ class SortWrapper {
   bool init();
   bool convertTDC();
   bool sort();
+  // the raw counts of the event reach the pre_sort_filter minimums, checked before sort()
+  bool isPassingPreSortFilter() const;
+  void finishCalibWorker();
   bool calibFactors() const;
   bool genClibTab() const;
 
@@ -78,6 +149,7 @@ class SortWrapper {
   bool isNull() const;
   bool isFull() const;
   int getNumHits() const;
+  int getNumOfAnodeHits() const;
   hit_class **getOutputArr() const;
   std::shared_ptr<double> getNthX(const int i) const;
   std::shared_ptr<double> getNthY(const int i) const;
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <sys/stat.h>
+#include <TApplication.h>
+#include <TSystem.h>
+#include <TCanvas.h>
+#include <TFile.h>
+#include <TH1.h>
+#include "../Core/Keyboard.h"
+
+// Draws the live snapshots of sp8sort or sp8ana, the processing loops only write them.
+// The file is read again whenever it is replaced.
+
+// the canvases of sp8sort
+const std::vector<std::string> defaultHists = {
+    "timesum/h1_ionTimesumU_afterSort", "timesum/h1_ionTimesumV_afterSort", "timesum/h1_ionTimesumW_afterSort",
+    "timesum/h1_ionTimediffU_afterSort", "timesum/h1_ionTimediffV_afterSort", "timesum/h1_ionTimediffW_afterSort",
+    "timesum/h2_ionXYRaw", "timesum/h2_ionXY", "timesum/h2_ionXYDev",
+    "timesum/h1_elecTimesumU_afterSort", "timesum/h1_elecTimesumV_afterSort", "timesum/h1_elecTimesumW_afterSort",
+    "timesum/h1_elecTimediffU_afterSort", "timesum/h1_elecTimediffV_afterSort", "timesum/h1_elecTimediffW_afterSort",
+    "timesum/h2_elecXYRaw", "timesum/h2_elecXY", "timesum/h2_elecXYDev"
+};
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    printf("syntax: sp8view snapshot_file [-i interval] [hist ...]\n");
+    printf("        The hists are given by their paths in the snapshot file, 9 per canvas.\n");
+    printf("        Without hists, the canvases of sp8sort are drawn.\n");
+    return 0;
+  }
+  const std::string filename = argv[1];
+  double interval = 2; // [s]
+  std::vector<std::string> hists;
+  for (int i = 2; i < argc; i++) {
+    if (std::string(argv[i]) == "-i" && i + 1 < argc) interval = atof(argv[++i]);
+    else hists.push_back(argv[i]);
+  }
+  if (interval <= 0) {
+    printf("The interval is invalid.\n");
+    return 1;
+  }
+  if (hists.empty()) hists = defaultHists;
+
+  int root_argc = 1;
+  TApplication theRootApp("theRootApp", &root_argc, argv);
+
+  const int numPads = 9;
+  const int numCanvases = ((int) hists.size() + numPads - 1) / numPads;
+  std::vector<TCanvas *> canvases;
+  for (int i = 0; i < numCanvases; i++) {
+    const std::string name = "sp8view_" + std::to_string(i);
+    canvases.push_back(new TCanvas(name.c_str(), filename.c_str(), 10 + 30 * i, 10 + 30 * i, 910, 910));
+    canvases.back()->Divide(3, 3);
+  }
+  std::vector<TH1 *> shown(hists.size(), nullptr);
+
+  std::cout << "Viewing " << filename << ". Hit any key to exit." << std::endl;
+  struct timespec lastModified = {0, 0};
+  double sinceLastCheck = interval;
+  while (!Analysis::kbhit()) { // waits 0.1 s
+    gSystem->ProcessEvents();
+    sinceLastCheck += 0.1;
+    if (sinceLastCheck < interval) continue;
+    sinceLastCheck = 0;
+
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0) continue;
+    if (st.st_mtim.tv_sec == lastModified.tv_sec && st.st_mtim.tv_nsec == lastModified.tv_nsec) continue;
+    lastModified = st.st_mtim;
+    TFile *pFile = TFile::Open(filename.c_str(), "READ");
+    if (!pFile) continue;
+    for (size_t i = 0; i < hists.size(); i++) {
+      TH1 *h = dynamic_cast<TH1 *>(pFile->Get(hists[i].c_str()));
+      if (!h) continue;
+      h->SetDirectory(nullptr); // keep it after the file is closed
+      auto pPad = canvases[i / numPads]->cd((int) (i % numPads) + 1);
+      pPad->Clear();
+      delete shown[i];
+      shown[i] = h;
+      h->Draw();
+    }
+    pFile->Close();
+    delete pFile;
+    for (auto pCanvas : canvases) {
+      for (int k = 1; k <= numPads; k++) {
+        pCanvas->cd(k)->Modified();
+        pCanvas->cd(k)->Update();
+      }
+    }
+  }
+
+  for (auto pCanvas : canvases) {
+    pCanvas->Close();
+    delete pCanvas;
+  }
+  for (auto h : shown) delete h;
+  theRootApp.Terminate();
+  return 0;
+}